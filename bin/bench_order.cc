@@ -0,0 +1,93 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <disc/graph/Graph.h>
+#include <disc/graph/Order.h>
+
+#include "common.h"
+
+namespace {
+
+  constexpr std::size_t BenchRuns = 3;
+
+  double measurePathCount(const disc::Graph& g, std::size_t length) {
+    double best = 0.0;
+
+    for (std::size_t i = 0; i < BenchRuns; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      auto paths = g.computePathCountOfMaximumLength(length);
+      auto finish = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> diff = finish - start;
+      best = (i == 0) ? diff.count() : std::min(best, diff.count());
+    }
+
+    return best;
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: bench_order <graph>...\n";
+    return EXIT_FAILURE;
+  }
+
+  static const char *names[] = { "none", "bfs", "rcm", "degree" };
+
+  for (int i = 1; i < argc; ++i) {
+    disc::Graph g = disc::Graph::importFile(argv[i]);
+
+    if (g.getVertexCount() == 0) {
+      std::cerr << "Can not import graph\n";
+      return EXIT_FAILURE;
+    }
+
+    std::size_t ecc = g.getEccentricity();
+    std::size_t length = static_cast<std::size_t>(disc::LengthFactor * ecc);
+
+    std::cout << argv[i] << " (" << g.getVertexCount() << " vertices, " << g.getEdgeCount() << " edges, length " << length << ")\n";
+
+    double reference = 0.0;
+
+    for (auto name : names) {
+      disc::VertexOrder order;
+      disc::parseVertexOrder(name, order);
+
+      auto start = std::chrono::steady_clock::now();
+      auto permuted = disc::permuteGraph(g, disc::computeVertexOrder(g, order));
+      auto finish = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> diff = finish - start;
+      double time = measurePathCount(permuted, length);
+
+      if (order == disc::VertexOrder::None) {
+        reference = time;
+      }
+
+      std::cout << '\t' << name << ": reorder " << diff.count() << "s, path count " << time << "s (x" << reference / time << ")\n";
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
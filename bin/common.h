@@ -1,12 +1,288 @@
 #ifndef DISC_COMMON_H
 #define DISC_COMMON_H
 
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <disc/graph/Cache.h>
+#include <disc/graph/Graph.h>
+#include <disc/graph/Order.h>
+#include <disc/graph/Parallel.h>
+#include <disc/graph/Problem.h>
+#include <disc/graph/Random.h>
+#include <disc/graph/Snapshot.h>
+
 namespace disc {
 
   constexpr double LengthFactor = 2;
 
   constexpr std::size_t CoverTries = 100;
 
+  /*
+   * command line options, common to all the tools
+   */
+
+  struct Options {
+    VertexOrder order = VertexOrder::None;
+    std::size_t threads = 0;
+    std::size_t checkpoint = NoCheckpoint;
+    std::size_t cache = 256 << 20; // in bytes
+    bool compressed = false;
+    CoOccurrence occurrence = CoOccurrence::Distinct;
+    bool seeded = false;
+    uint64_t seed = 0;
+    std::string snapshot;
+    double snapshotInterval = 600; // in seconds
+    LpOptions lp;
+    std::string warmStart;
+  };
+
+  constexpr const char *OptionsUsage =
+    "Options:\n"
+    "\t--order <none|bfs|rcm|degree> reorder the vertices of the graph\n"
+    "\t--threads <n> number of threads (default: all the hardware threads)\n"
+    "\t--checkpoint <n|auto> keep one layer of path counts out of n when generating a path, without the cache (auto: square root of the length)\n"
+    "\t--cache <MiB> memory budget for the path counts reused between paths, unused with --checkpoint (default: 256, 0 to disable)\n"
+    "\t--compressed count the paths on the compressed adjacency (graph_features)\n"
+    "\t--seed <n> seed of the random engine, for reproducible results\n"
+    "\t--multiplicity count every occurrence of a vertex in a path in the approximated alpha matrix\n"
+    "\t--snapshot <file> save the alpha matrix computation in the file, and resume it from the file\n"
+    "\t--snapshot-interval <min> minutes between two saves of the snapshot (default: 10)\n"
+    "\t--lp <simplex|interior|mirror-prox> method of the LP solver (default: simplex)\n"
+    "\t--presolve use the presolver of the simplex\n"
+    "\t--lp-time <min> time limit of the simplex and the mirror prox (default: 20, 0 for no limit)\n"
+    "\t--warm-start <file> start the simplex from the pi of a previous run, the file only contains the pi separated by spaces\n"
+    "\t--accuracy <eps> relative gap between the bounds of p_min for the mirror prox (default: 0.001)\n"
+    "\t--iterations <n> maximum number of iterations of the mirror prox (default: 100000)\n"
+    "\t--no-reduce solve the LP without merging the identical and dominated states\n";
+
+  // parses the options and removes them from the arguments
+  inline bool parseOptions(int& argc, char *argv[], Options& options) {
+    int count = 1;
+
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+
+      if (arg == "--order") {
+        if (i + 1 == argc || !parseVertexOrder(argv[++i], options.order)) {
+          std::cerr << "Invalid order\n";
+          return false;
+        }
+      } else if (arg == "--threads") {
+        char *end = nullptr;
+
+        if (i + 1 == argc || (options.threads = std::strtoul(argv[++i], &end, 10)) == 0 || *end != '\0') {
+          std::cerr << "Invalid thread count\n";
+          return false;
+        }
+      } else if (arg == "--checkpoint") {
+        char *end = nullptr;
+
+        if (i + 1 == argc) {
+          std::cerr << "Invalid checkpoint interval\n";
+          return false;
+        }
+
+        if (std::string(argv[++i]) == "auto") {
+          options.checkpoint = AutoCheckpoint;
+        } else if ((options.checkpoint = std::strtoul(argv[i], &end, 10)) == 0 || *end != '\0') {
+          std::cerr << "Invalid checkpoint interval\n";
+          return false;
+        }
+      } else if (arg == "--cache") {
+        char *end = nullptr;
+
+        if (i + 1 == argc || (options.cache = std::strtoul(argv[++i], &end, 10)) > (std::size_t(-1) >> 20) || *end != '\0') {
+          std::cerr << "Invalid cache budget\n";
+          return false;
+        }
+
+        options.cache <<= 20;
+      } else if (arg == "--compressed") {
+        options.compressed = true;
+      } else if (arg == "--seed") {
+        char *end = nullptr;
+
+        if (i + 1 == argc) {
+          std::cerr << "Invalid seed\n";
+          return false;
+        }
+
+        options.seed = std::strtoull(argv[++i], &end, 10);
+        options.seeded = true;
+
+        if (*end != '\0') {
+          std::cerr << "Invalid seed\n";
+          return false;
+        }
+      } else if (arg == "--multiplicity") {
+        options.occurrence = CoOccurrence::Multiplicity;
+      } else if (arg == "--snapshot") {
+        if (i + 1 == argc) {
+          std::cerr << "Invalid snapshot\n";
+          return false;
+        }
+
+        options.snapshot = argv[++i];
+      } else if (arg == "--snapshot-interval") {
+        char *end = nullptr;
+
+        if (i + 1 == argc || (options.snapshotInterval = std::strtod(argv[++i], &end)) < 0 || *end != '\0') {
+          std::cerr << "Invalid snapshot interval\n";
+          return false;
+        }
+
+        options.snapshotInterval *= 60;
+      } else if (arg == "--lp") {
+        std::string method = i + 1 == argc ? "" : argv[++i];
+
+        if (method == "simplex") {
+          options.lp.method = LpMethod::Simplex;
+        } else if (method == "interior") {
+          options.lp.method = LpMethod::InteriorPoint;
+        } else if (method == "mirror-prox") {
+          options.lp.method = LpMethod::MirrorProx;
+        } else {
+          std::cerr << "Invalid LP method\n";
+          return false;
+        }
+      } else if (arg == "--accuracy") {
+        char *end = nullptr;
+
+        if (i + 1 == argc || !((options.lp.accuracy = std::strtod(argv[++i], &end)) > 0) || *end != '\0') {
+          std::cerr << "Invalid accuracy\n";
+          return false;
+        }
+      } else if (arg == "--iterations") {
+        char *end = nullptr;
+
+        if (i + 1 == argc || (options.lp.iterations = std::strtoul(argv[++i], &end, 10)) == 0 || *end != '\0') {
+          std::cerr << "Invalid iteration count\n";
+          return false;
+        }
+      } else if (arg == "--no-reduce") {
+        options.lp.reduce = false;
+      } else if (arg == "--presolve") {
+        options.lp.presolve = true;
+      } else if (arg == "--lp-time") {
+        char *end = nullptr;
+
+        if (i + 1 == argc || (options.lp.timeLimit = std::strtod(argv[++i], &end)) < 0 || *end != '\0') {
+          std::cerr << "Invalid LP time limit\n";
+          return false;
+        }
+
+        options.lp.timeLimit *= 60;
+      } else if (arg == "--warm-start") {
+        if (i + 1 == argc) {
+          std::cerr << "Invalid warm start\n";
+          return false;
+        }
+
+        options.warmStart = argv[++i];
+      } else {
+        argv[count++] = argv[i];
+      }
+    }
+
+    argc = count;
+    setThreadCount(options.threads);
+    return true;
+  }
+
+  // imports and reorders the graph, the order is used to restore the original ids
+  inline Graph importGraph(const char *filename, const Options& options, std::vector<VertexDescriptor>& order) {
+    std::cerr << "Importing graph...\n";
+    Graph g = Graph::importFile(filename);
+
+    if (g.getVertexCount() == 0) {
+      std::cerr << "Can not import graph\n";
+      return g;
+    }
+
+    order = computeVertexOrder(g, options.order);
+
+    if (options.order != VertexOrder::None) {
+      std::cerr << "Reordering graph...\n";
+      g = permuteGraph(g, order);
+    }
+
+    return g;
+  }
+
+  inline Engine makeEngine(const Options& options) {
+    if (options.seeded) {
+      return getStreamEngine(options.seed, 0);
+    }
+
+    return getCorrectlyInitializedEngine();
+  }
+
+  // returns null if there is no snapshot
+  inline std::unique_ptr<AlphaSnapshot> makeSnapshot(const Options& options) {
+    if (options.snapshot.empty()) {
+      return nullptr;
+    }
+
+    return std::unique_ptr<AlphaSnapshot>(new AlphaSnapshot(options.snapshot, options.snapshotInterval));
+  }
+
+  // the LP options with the warm start read from its file. The file only
+  // contains the pi, separated by spaces or new lines, in the original order
+  // of the vertices: the pi line of the output of a previous run. Returns
+  // false if the file is not in this format or does not match the graph.
+  inline bool makeLpOptions(const Options& options, const std::vector<VertexDescriptor>& order, LpOptions& lp) {
+    lp = options.lp;
+
+    if (options.warmStart.empty()) {
+      return true;
+    }
+
+    std::ifstream file(options.warmStart);
+
+    if (!file) {
+      std::cerr << "Can not open warm start '" << options.warmStart << "'\n";
+      return false;
+    }
+
+    std::vector<double> values;
+    std::string token;
+
+    while (file >> token) {
+      char *end = nullptr;
+      double x = std::strtod(token.c_str(), &end);
+
+      if (*end != '\0' || !std::isfinite(x) || x < 0) {
+        std::cerr << "Invalid warm start: '" << token << "' is not a pi, the file must only contain the pi\n";
+        return false;
+      }
+
+      values.push_back(x);
+    }
+
+    if (values.size() != order.size()) {
+      std::cerr << "Invalid warm start: " << values.size() << " values for " << order.size() << " vertices\n";
+      return false;
+    }
+
+    lp.start.resize(values.size());
+
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      lp.start[i] = values[order[i].index];
+    }
+
+    return true;
+  }
+
+  inline void printCacheStatistics(const PathCountCache& cache) {
+    std::cerr << "Path count cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses\n";
+  }
+
 }
 
 #endif // DISC_COMMON_H
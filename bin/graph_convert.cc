@@ -0,0 +1,45 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cstdlib>
+
+#include <iostream>
+
+#include <disc/graph/Graph.h>
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: graph_convert <graph> <binary graph>\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cerr << "Importing graph...\n";
+  disc::Graph g = disc::Graph::importFile(argv[1]);
+
+  if (g.getVertexCount() == 0) {
+    std::cerr << "Can not import graph\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cerr << "Exporting binary graph...\n";
+
+  if (!g.exportBinary(argv[2])) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -18,21 +18,27 @@
 #include <cstdlib>
 
 #include <iostream>
-#include <fstream>
 
+#include <disc/graph/Compressed.h>
 #include <disc/graph/Graph.h>
+#include <disc/graph/Path.h>
 
 #include "common.h"
 
 int main(int argc, char *argv[]) {
-  if (argc != 2) {
-    std::cerr << "Usage: graph_features <graph>\n";
+  disc::Options options;
+
+  if (!disc::parseOptions(argc, argv, options) || argc != 2) {
+    std::cerr << "Usage: graph_features [options] <graph>\n" << disc::OptionsUsage;
     return EXIT_FAILURE;
   }
 
-  std::cerr << "Importing graph...\n";
-  std::ifstream input(argv[1]);
-  disc::Graph g = disc::Graph::import(input);
+  std::vector<disc::VertexDescriptor> order;
+  disc::Graph g = disc::importGraph(argv[1], options, order);
+
+  if (g.getVertexCount() == 0) {
+    return EXIT_FAILURE;
+  }
 
   std::cout << "G has " << g.getVertexCount() << " vertices\n";
   std::cout << "G has " << g.getEdgeCount() << " edges\n";
@@ -54,6 +60,18 @@ int main(int argc, char *argv[]) {
 
   std::size_t length = static_cast<std::size_t>(disc::LengthFactor * ecc);
 
+  if (options.compressed) {
+    disc::CompressedGraph cg(g);
+    g.clear();
+
+    std::size_t size = cg.getMemorySize();
+    std::cout << "Compressed adjacency: " << size << " bytes (" << static_cast<double>(size) / cg.getEdgeCount() << " bytes per edge)\n";
+
+    auto pathCount = disc::countPathOfMaximumLengthFromInitialState(cg, length);
+    std::cout << "Path of length " << length << ": " << pathCount << '\n';
+    return EXIT_SUCCESS;
+  }
+
   auto pathCount = g.countPathOfMaximumLengthFromInitialState(length);
   std::cout << "Path of length " << length << ": " << pathCount << '\n';
 
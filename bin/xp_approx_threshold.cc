@@ -18,7 +18,6 @@
 #include <cstdlib>
 
 #include <iostream>
-#include <fstream>
 
 #include <disc/graph/Cover.h>
 #include <disc/graph/Graph.h>
@@ -29,29 +28,41 @@
 #include "common.h"
 
 int main(int argc, char *argv[]) {
-  if (argc != 4) {
-    std::cerr << "Usage: xp_approx <graph> <factor> <threshold>\n";
+  disc::Options options;
+
+  if (!disc::parseOptions(argc, argv, options) || argc != 4) {
+    std::cerr << "Usage: xp_approx [options] <graph> <factor> <threshold>\n" << disc::OptionsUsage;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<disc::VertexDescriptor> order;
+  disc::Graph g = disc::importGraph(argv[1], options, order);
+
+  if (g.getVertexCount() == 0) {
     return EXIT_FAILURE;
   }
 
-  std::cerr << "Importing graph...\n";
-  std::ifstream input(argv[1]);
-  disc::Graph g = disc::Graph::import(input);
+  disc::LpOptions lp;
+
+  if (!disc::makeLpOptions(options, order, lp)) {
+    return EXIT_FAILURE;
+  }
 
   std::size_t factor = std::stoul(argv[2]);
   double threshold = std::stod(argv[3]);
 
-  disc::Engine engine = disc::getCorrectlyInitializedEngine();
+  disc::Engine engine = disc::makeEngine(options);
 
   std::size_t ecc = g.getEccentricity();
   std::size_t length = static_cast<std::size_t>(disc::LengthFactor * ecc);
 
   // random
 
-  auto coeffs = g.computeApproxNormalizedAlphaMatrixWithThreshold(length, g.getVertexCount() * factor, engine, threshold);
-  auto pi = disc::computePii(coeffs, nullptr);
+  auto snapshot = disc::makeSnapshot(options);
+  auto coeffs = g.computeApproxNormalizedAlphaMatrixWithThreshold(length, g.getVertexCount() * factor, engine, threshold, options.occurrence, snapshot.get());
+  auto pi = disc::computePii(coeffs, nullptr, lp);
 
-  for (auto x : pi) {
+  for (auto x : disc::restoreVertexOrder(pi, order)) {
     std::cout << x << ' ';
   }
   std::cout << '\n';
@@ -59,7 +70,9 @@ int main(int argc, char *argv[]) {
   std::discrete_distribution<uint64_t> distribution(pi.begin(), pi.end());
 
   std::cout << "Approx-" << factor << " :\n";
-  auto metrics = disc::coverGraphMultiple(g, engine, distribution, length, disc::CoverTries);
+  disc::PathCountCache cache(options.cache);
+  auto metrics = disc::coverGraphMultiple(g, engine, distribution, length, disc::CoverTries, options.checkpoint, &cache);
+  disc::printCacheStatistics(cache);
   auto mean = disc::computeMeanMetrics(metrics);
   std::cout << mean << '\n';
 
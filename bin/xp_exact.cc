@@ -18,7 +18,6 @@
 #include <cstdlib>
 
 #include <iostream>
-#include <fstream>
 
 #include <disc/graph/Cover.h>
 #include <disc/graph/Graph.h>
@@ -29,26 +28,38 @@
 #include "common.h"
 
 int main(int argc, char *argv[]) {
-  if (argc != 2) {
-    std::cerr << "Usage: xp_exact <graph>\n";
+  disc::Options options;
+
+  if (!disc::parseOptions(argc, argv, options) || argc != 2) {
+    std::cerr << "Usage: xp_exact [options] <graph>\n" << disc::OptionsUsage;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<disc::VertexDescriptor> order;
+  disc::Graph g = disc::importGraph(argv[1], options, order);
+
+  if (g.getVertexCount() == 0) {
     return EXIT_FAILURE;
   }
 
-  std::cerr << "Importing graph...\n";
-  std::ifstream input(argv[1]);
-  disc::Graph g = disc::Graph::import(input);
+  disc::LpOptions lp;
+
+  if (!disc::makeLpOptions(options, order, lp)) {
+    return EXIT_FAILURE;
+  }
 
-  disc::Engine engine = disc::getCorrectlyInitializedEngine();
+  disc::Engine engine = disc::makeEngine(options);
 
   std::size_t ecc = g.getEccentricity();
   std::size_t length = static_cast<std::size_t>(disc::LengthFactor * ecc);
 
   // random
 
-  auto coeffs = g.computeExactNormalizedAlphaMatrix(length);
-  auto pi = disc::computePii(coeffs, nullptr);
+  auto snapshot = disc::makeSnapshot(options);
+  auto coeffs = g.computeExactNormalizedAlphaMatrix(length, snapshot.get());
+  auto pi = disc::computePii(coeffs, nullptr, lp);
 
-  for (auto x : pi) {
+  for (auto x : disc::restoreVertexOrder(pi, order)) {
     std::cout << x << ' ';
   }
   std::cout << '\n';
@@ -56,7 +67,9 @@ int main(int argc, char *argv[]) {
   std::discrete_distribution<uint64_t> distribution(pi.begin(), pi.end());
 
   std::cout << "Exact:\n";
-  auto metrics = disc::coverGraphMultiple(g, engine, distribution, length, disc::CoverTries);
+  disc::PathCountCache cache(options.cache);
+  auto metrics = disc::coverGraphMultiple(g, engine, distribution, length, disc::CoverTries, options.checkpoint, &cache);
+  disc::printCacheStatistics(cache);
   auto mean = disc::computeMeanMetrics(metrics);
   std::cout << mean << '\n';
 
@@ -18,7 +18,6 @@
 #include <cstdlib>
 
 #include <iostream>
-#include <fstream>
 
 #include <disc/graph/Cover.h>
 #include <disc/graph/Graph.h>
@@ -28,16 +27,21 @@
 #include "common.h"
 
 int main(int argc, char *argv[]) {
-  if (argc != 2) {
-    std::cerr << "Usage: xp_uniform <graph>\n";
+  disc::Options options;
+
+  if (!disc::parseOptions(argc, argv, options) || argc != 2) {
+    std::cerr << "Usage: xp_uniform [options] <graph>\n" << disc::OptionsUsage;
     return EXIT_FAILURE;
   }
 
-  std::cerr << "Importing graph...\n";
-  std::ifstream input(argv[1]);
-  disc::Graph g = disc::Graph::import(input);
+  std::vector<disc::VertexDescriptor> order;
+  disc::Graph g = disc::importGraph(argv[1], options, order);
+
+  if (g.getVertexCount() == 0) {
+    return EXIT_FAILURE;
+  }
 
-  disc::Engine engine = disc::getCorrectlyInitializedEngine();
+  disc::Engine engine = disc::makeEngine(options);
 
   std::size_t ecc = g.getEccentricity();
   std::size_t length = static_cast<std::size_t>(disc::LengthFactor * ecc);
@@ -46,7 +50,9 @@ int main(int argc, char *argv[]) {
   std::uniform_int_distribution<uint64_t> distribution(0, count - 1);
 
   std::cout << "Uniform:\n";
-  auto metrics = disc::coverGraphMultiple(g, engine, distribution, length, disc::CoverTries);
+  disc::PathCountCache cache(options.cache);
+  auto metrics = disc::coverGraphMultiple(g, engine, distribution, length, disc::CoverTries, options.checkpoint, &cache);
+  disc::printCacheStatistics(cache);
   auto mean = disc::computeMeanMetrics(metrics);
   std::cout << mean << '\n';
 
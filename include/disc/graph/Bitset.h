@@ -0,0 +1,170 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_BITSET_H
+#define DISC_BITSET_H
+
+#include <cassert>
+#include <cstdint>
+
+#include <vector>
+
+namespace disc {
+
+  class Bitset {
+  public:
+    using Word = uint64_t;
+
+    static constexpr std::size_t WordBits = 64;
+
+    explicit Bitset(std::size_t size = 0)
+    : m_size(size)
+    , m_words(getWordCount(size), 0)
+    {
+    }
+
+    // capacity
+
+    std::size_t getSize() const {
+      return m_size;
+    }
+
+    void reserve(std::size_t size) {
+      m_words.reserve(getWordCount(size));
+    }
+
+    void resize(std::size_t size) {
+      m_size = size;
+      m_words.resize(getWordCount(size), 0);
+
+      if (size % WordBits != 0) {
+        m_words.back() &= (Word(1) << (size % WordBits)) - 1;
+      }
+    }
+
+    // element access
+
+    bool test(std::size_t i) const {
+      assert(i < m_size);
+      return (m_words[i / WordBits] >> (i % WordBits)) & 1;
+    }
+
+    void set(std::size_t i) {
+      assert(i < m_size);
+      m_words[i / WordBits] |= Word(1) << (i % WordBits);
+    }
+
+    void reset(std::size_t i) {
+      assert(i < m_size);
+      m_words[i / WordBits] &= ~(Word(1) << (i % WordBits));
+    }
+
+    void clear() {
+      m_size = 0;
+      m_words.clear();
+    }
+
+    std::size_t count() const {
+      std::size_t res = 0;
+
+      for (auto word : m_words) {
+        res += __builtin_popcountll(word);
+      }
+
+      return res;
+    }
+
+    // raw data
+
+    const Word *getData() const {
+      return m_words.data();
+    }
+
+    Word *getData() {
+      return m_words.data();
+    }
+
+    static std::size_t getWordCount(std::size_t size) {
+      return (size + WordBits - 1) / WordBits;
+    }
+
+  private:
+    std::size_t m_size;
+    std::vector<Word> m_words;
+  };
+
+  /*
+   * CountedBitset
+   *
+   * Bitset with the number of bits set kept up to date, for the visited
+   * vertices of the covers. There is no raw access, so the count can not
+   * get out of sync.
+   */
+  class CountedBitset {
+  public:
+    explicit CountedBitset(std::size_t size = 0)
+    : m_bits(size)
+    , m_count(0)
+    {
+    }
+
+    std::size_t getSize() const {
+      return m_bits.getSize();
+    }
+
+    std::size_t getCount() const {
+      return m_count;
+    }
+
+    bool isFull() const {
+      return m_count == m_bits.getSize();
+    }
+
+    bool test(std::size_t i) const {
+      return m_bits.test(i);
+    }
+
+    // returns true if the bit was not set
+    bool insert(std::size_t i) {
+      if (m_bits.test(i)) {
+        return false;
+      }
+
+      m_bits.set(i);
+      ++m_count;
+      return true;
+    }
+
+    // returns true if the bit was set
+    bool erase(std::size_t i) {
+      if (!m_bits.test(i)) {
+        return false;
+      }
+
+      m_bits.reset(i);
+      --m_count;
+      return true;
+    }
+
+  private:
+    Bitset m_bits;
+    std::size_t m_count;
+  };
+
+}
+
+#endif // DISC_BITSET_H
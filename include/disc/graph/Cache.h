@@ -0,0 +1,157 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_CACHE_H
+#define DISC_CACHE_H
+
+#include <cstdint>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Crossing.h"
+#include "Graph.h"
+#include "Matrix.h"
+#include "Random.h"
+
+namespace disc {
+
+  /*
+   * CachedPathCount
+   *
+   * The path counts of maximum length of a graph crossing one vertex. The
+   * second copy of the origin graph has the path counts of the origin graph,
+   * whatever the crossing vertex, so these counts are shared and only the
+   * counts of the first copy are specific to the crossing vertex. It has the
+   * interface of Matrix<double> needed by makeUniformPath.
+   */
+  class CachedPathCount {
+  public:
+    CachedPathCount() = default;
+
+    CachedPathCount(std::shared_ptr<const Matrix<double>> crossing, std::shared_ptr<const Matrix<double>> origin)
+    : m_crossing(std::move(crossing))
+    , m_origin(std::move(origin))
+    {
+    }
+
+    explicit operator bool() const {
+      return m_crossing != nullptr;
+    }
+
+    std::size_t getRows() const {
+      return 2 * m_crossing->getRows();
+    }
+
+    std::size_t getCols() const {
+      return m_crossing->getCols();
+    }
+
+    double operator()(std::size_t row, std::size_t col) const {
+      std::size_t count = m_crossing->getRows();
+      return row < count ? (*m_crossing)(row, col) : (*m_origin)(row - count, col);
+    }
+
+  private:
+    std::shared_ptr<const Matrix<double>> m_crossing;
+    std::shared_ptr<const Matrix<double>> m_origin;
+  };
+
+  /*
+   * PathCountCache
+   *
+   * Cache of the path counts of maximum length of the graphs crossing one
+   * vertex, keyed by the vertex and the length. Only the counts of the first
+   * copy are kept for each vertex, the counts of the origin graph are kept
+   * once per length while an entry of this length uses them. The least
+   * recently used counts are evicted when the memory budget (in bytes) is
+   * exceeded. The cache is for a single origin
+   * graph and is thread-safe: the counts are computed outside the lock, so
+   * threads that miss the same key at the same time compute it each, and the
+   * budget may be exceeded by the counts being computed. The counts that can
+   * never fit in the budget are not counted as misses.
+   */
+  class PathCountCache {
+  public:
+    explicit PathCountCache(std::size_t budget);
+
+    // returns empty counts if the counts do not fit in the budget
+    CachedPathCount getPathCount(const GraphCrossingOneVertex& derived, std::size_t length);
+
+    std::size_t getBudget() const {
+      return m_budget;
+    }
+
+    std::size_t getMemorySize() const {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_size;
+    }
+
+    std::size_t getHits() const {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_hits;
+    }
+
+    std::size_t getMisses() const {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_misses;
+    }
+
+  private:
+    using Key = std::pair<uint64_t, std::size_t>;
+
+    struct Entry {
+      Key key;
+      std::size_t size;
+      std::shared_ptr<const Matrix<double>> paths;
+    };
+
+    // the counts of the origin graph for a length, and the number of entries
+    // of this length
+    struct Origin {
+      std::shared_ptr<const Matrix<double>> paths;
+      std::size_t size;
+      std::size_t references;
+    };
+
+    // evicts the least recently used entry, and the counts of the origin
+    // graph if no other entry uses them
+    void evict();
+
+    mutable std::mutex m_mutex;
+    std::size_t m_budget;
+    std::size_t m_size;
+    std::size_t m_hits;
+    std::size_t m_misses;
+    const Graph *m_graph;
+    std::list<Entry> m_entries; // most recently used first
+    std::map<Key, std::list<Entry>::iterator> m_index;
+    std::map<std::size_t, Origin> m_origins; // by length
+  };
+
+  // generates a uniform path on the graph crossing one vertex, with the path
+  // counts computed with the checkpoint interval if any, or else from the
+  // cache if any, as the cache keeps all the layers of the counts
+  std::vector<VertexDescriptor> makeCrossingUniformPath(const GraphCrossingOneVertex& derived, std::size_t length, Engine& engine, std::size_t checkpoint, PathCountCache *cache);
+
+}
+
+#endif // DISC_CACHE_H
@@ -0,0 +1,167 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_COMPRESSED_H
+#define DISC_COMPRESSED_H
+
+#include <cstdint>
+
+#include <vector>
+
+#include "Bitset.h"
+#include "Graph.h"
+
+namespace disc {
+
+  /*
+   * Range over the successors of a vertex in a compressed graph. The
+   * successors are decoded on the fly.
+   */
+  class CompressedSuccessorRange {
+  public:
+    CompressedSuccessorRange(const uint8_t *beg, const uint8_t *end)
+    : m_beg(beg)
+    , m_end(end)
+    {
+    }
+
+    struct iterator {
+      iterator& operator++() {
+        pos = next;
+
+        if (pos != end) {
+          value += decode();
+        }
+
+        return *this;
+      }
+
+      VertexDescriptor operator*() const {
+        return { value };
+      }
+
+      bool operator!=(const iterator& other) const {
+        return pos != other.pos;
+      }
+
+      uint64_t decode() {
+        uint64_t res = 0;
+        unsigned shift = 0;
+
+        next = pos;
+
+        while (*next & 0x80) {
+          res |= uint64_t(*next & 0x7F) << shift;
+          shift += 7;
+          ++next;
+        }
+
+        res |= uint64_t(*next) << shift;
+        ++next;
+        return res;
+      }
+
+      const uint8_t *pos;
+      const uint8_t *next;
+      const uint8_t *end;
+      uint64_t value;
+    };
+
+    iterator begin() const {
+      iterator it = { m_beg, m_beg, m_end, 0 };
+
+      if (m_beg != m_end) {
+        it.value = it.decode();
+      }
+
+      return it;
+    }
+
+    iterator end() const {
+      return { m_end, m_end, m_end, 0 };
+    }
+
+  private:
+    const uint8_t *m_beg;
+    const uint8_t *m_end;
+  };
+
+  /*
+   * CompressedGraph
+   *
+   * Read-only version of a graph where the successors of each vertex are
+   * sorted and stored as deltas encoded in variable length integers (7 bits
+   * per byte). It can be used by the path counting and path generation
+   * algorithms of Path.h. Building it from a memory mapped binary graph
+   * avoids keeping the uncompressed adjacency in memory.
+   */
+  class CompressedGraph {
+  public:
+    explicit CompressedGraph(const Graph& g);
+
+    // vertices
+
+    Graph::VertexRange getVertices() const {
+      return makeIntegerRange<VertexDescriptor>({ 0 }, { m_vertexCount });
+    }
+
+    std::size_t getVertexCount() const {
+      return m_vertexCount;
+    }
+
+    // edges
+
+    std::size_t getEdgeCount() const {
+      return m_edgeCount;
+    }
+
+    // adjacency
+
+    CompressedSuccessorRange getSuccessors(VertexDescriptor v) const {
+      const uint8_t *data = m_data.data();
+      return CompressedSuccessorRange(data + m_offsets[v.index], data + m_offsets[v.index + 1]);
+    }
+
+    // initial and final states
+
+    VertexDescriptor getInitialState() const {
+      return m_initialState;
+    }
+
+    bool isInitialState(VertexDescriptor v) const {
+      return v == m_initialState;
+    }
+
+    bool isFinalState(VertexDescriptor v) const {
+      return m_finalStates.test(v.index);
+    }
+
+    // size of the adjacency, in bytes
+    std::size_t getMemorySize() const;
+
+  private:
+    std::size_t m_vertexCount;
+    std::size_t m_edgeCount;
+    std::vector<uint64_t> m_offsets;
+    std::vector<uint8_t> m_data;
+    VertexDescriptor m_initialState;
+    Bitset m_finalStates;
+  };
+
+}
+
+#endif // DISC_COMPRESSED_H
@@ -18,27 +18,58 @@
 #ifndef DISC_COVER_H
 #define DISC_COVER_H
 
+#include <cstdint>
 #include <iostream>
 
+#include "Cache.h"
+#include "Crossing.h"
 #include "Graph.h"
 #include "Metrics.h"
+#include "Parallel.h"
+#include "Path.h"
 #include "Random.h"
 
 namespace disc {
 
+  // the seed of the engines of the tries, drawn from the engine
+  uint64_t makeCoverSeed(Engine& engine);
+
+  /*
+   * Calls func(engine) for every try, in parallel. Try i has its own engine,
+   * the stream i of a seed drawn from the engine, and the metrics are in the
+   * order of the tries, so that the results do not depend on the number of
+   * threads. The progress is only printed here, as the tries run
+   * concurrently.
+   */
+  template<typename Func>
+  std::vector<Metrics> coverGraphTries(Engine& engine, std::size_t tries, Func func) {
+    uint64_t seed = makeCoverSeed(engine);
+    std::vector<Metrics> results(tries);
+    Progress progress(tries);
+
+    parallelForEach(tries, [&](std::size_t i) {
+      Engine local = getStreamEngine(seed, i);
+      results[i] = func(local);
+      progress.add();
+    });
+
+    progress.finish();
+    return results;
+  }
+
   Metrics coverGraphOnceRandom(const Graph& g, Engine& engine, std::size_t length);
   std::vector<Metrics> coverGraphMultipleRandom(const Graph& g, Engine& engine, std::size_t length, std::size_t tries);
 
-  Metrics coverGraphOnceUnexplored(const Graph& g, Engine& engine, std::size_t length);
-  std::vector<Metrics> coverGraphMultipleUnexplored(const Graph& g, Engine& engine, std::size_t length, std::size_t tries);
+  Metrics coverGraphOnceUnexplored(const Graph& g, Engine& engine, std::size_t length, std::size_t checkpoint = NoCheckpoint, PathCountCache *cache = nullptr);
+  std::vector<Metrics> coverGraphMultipleUnexplored(const Graph& g, Engine& engine, std::size_t length, std::size_t tries, std::size_t checkpoint = NoCheckpoint, PathCountCache *cache = nullptr);
 
   template<typename Distribution>
-  Metrics coverGraphOnce(const Graph& g, Engine& engine, Distribution distribution, std::size_t length) {
+  Metrics coverGraphOnce(const Graph& g, Engine& engine, Distribution distribution, std::size_t length, std::size_t checkpoint = NoCheckpoint, PathCountCache *cache = nullptr) {
     Metrics res;
 
     std::size_t count = g.getVertexCount();
 
-    std::set<VertexDescriptor> visited;
+    CountedBitset visited(count);
 
     std::size_t iterations = 0;
 
@@ -47,40 +78,42 @@ namespace disc {
     bool has_95 = false;
     bool has_99 = false;
 
-    while (visited.size() != count) {
+    while (!visited.isFull()) {
       VertexDescriptor v = distribution(engine);
 
-      auto derived = buildGraphCrossingOneVertex(g, v);
-      auto paths = derived.computePathCountOfMaximumLength(length);
-      auto path = derived.makeUniformPath(length, engine, paths);
+      GraphCrossingOneVertex derived(g, v);
+      auto path = makeCrossingUniformPath(derived, length, engine, checkpoint, cache);
 
-      auto newlyVisited = derived.getVertexData(path);
-      visited.insert(newlyVisited.begin(), newlyVisited.end());
+      std::size_t newlyVisited = 0;
+
+      for (auto dv : path) {
+        newlyVisited += visited.insert(derived(dv).index) ? 1 : 0;
+      }
 
       ++iterations;
 
-      if (!has_50 && 2 * visited.size() >= count) {
+      if (newlyVisited == 0) {
+        continue;
+      }
+
+      if (!has_50 && 2 * visited.getCount() >= count) {
         has_50 = true;
         res.covered_50 = iterations;
-        std::cout << '5' << std::flush;
       }
 
-      if (!has_90 && 10 * visited.size() >= 9 * count) {
+      if (!has_90 && 10 * visited.getCount() >= 9 * count) {
         has_90 = true;
         res.covered_90 = iterations;
-        std::cout << '9' << std::flush;
       }
 
-      if (!has_95 && 20 * visited.size() >= 19 * count) {
+      if (!has_95 && 20 * visited.getCount() >= 19 * count) {
         has_95 = true;
         res.covered_95 = iterations;
-        std::cout << '=' << std::flush;
       }
 
-      if (!has_99 && 100 * visited.size() >= 99 * count) {
+      if (!has_99 && 100 * visited.getCount() >= 99 * count) {
         has_99 = true;
         res.covered_99 = iterations;
-        std::cout << '-' << std::flush;
       }
     }
 
@@ -89,17 +122,10 @@ namespace disc {
   }
 
   template<typename Distribution>
-  std::vector<Metrics> coverGraphMultiple(const Graph& g, Engine& engine, Distribution distribution, std::size_t length, std::size_t tries) {
-    std::vector<Metrics> results;
-
-    for (std::size_t i = 0; i < tries; ++i) {
-      auto m = coverGraphOnce(g, engine, distribution, length);
-      std::cout << '.' << std::flush;
-      results.push_back(m);
-    }
-
-    std::cout << '\n';
-    return results;
+  std::vector<Metrics> coverGraphMultiple(const Graph& g, Engine& engine, Distribution distribution, std::size_t length, std::size_t tries, std::size_t checkpoint = NoCheckpoint, PathCountCache *cache = nullptr) {
+    return coverGraphTries(engine, tries, [&](Engine& local) {
+      return coverGraphOnce(g, local, distribution, length, checkpoint, cache);
+    });
   }
 
 }
@@ -0,0 +1,161 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_CROSSING_H
+#define DISC_CROSSING_H
+
+#include <cassert>
+
+#include <limits>
+#include <set>
+#include <vector>
+
+#include "Graph.h"
+
+namespace disc {
+
+  /*
+   * Range over the successors of a vertex in the origin graph, shifted to
+   * another copy of the origin graph.
+   */
+  class ShiftedSuccessorRange {
+  public:
+    ShiftedSuccessorRange(Graph::SuccessorRange successors, std::size_t shift)
+    : m_beg(successors.begin())
+    , m_end(successors.end())
+    , m_shift(shift)
+    {
+    }
+
+    struct iterator {
+      iterator& operator++() {
+        ++ptr;
+        return *this;
+      }
+
+      VertexDescriptor operator*() const {
+        return { ptr->index + shift };
+      }
+
+      bool operator!=(const iterator& other) const {
+        return ptr != other.ptr;
+      }
+
+      const VertexDescriptor *ptr;
+      std::size_t shift;
+    };
+
+    iterator begin() const {
+      return { m_beg, m_shift };
+    }
+
+    iterator end() const {
+      return { m_end, m_shift };
+    }
+
+  private:
+    const VertexDescriptor *m_beg;
+    const VertexDescriptor *m_end;
+    std::size_t m_shift;
+  };
+
+  /*
+   * GraphCrossingOneVertex
+   *
+   * The graph of the paths crossing x, made of two copies of the origin
+   * graph: the paths go from the first copy to the second copy when they
+   * leave x. Nothing is built, everything is computed from the origin graph.
+   */
+  class GraphCrossingOneVertex {
+  public:
+    GraphCrossingOneVertex(const Graph& origin, VertexDescriptor x)
+    : m_origin(origin)
+    , m_count(origin.getVertexCount())
+    , m_x(x)
+    {
+      assert(2 * m_count <= std::numeric_limits<Index>::max());
+    }
+
+    const Graph& getOrigin() const {
+      return m_origin;
+    }
+
+    VertexDescriptor getCrossingVertex() const {
+      return m_x;
+    }
+
+    // vertices
+
+    Graph::VertexRange getVertices() const {
+      return makeIntegerRange<VertexDescriptor>({ 0 }, { 2 * m_count });
+    }
+
+    std::size_t getVertexCount() const {
+      return 2 * m_count;
+    }
+
+    VertexDescriptor operator()(VertexDescriptor v) const {
+      return { v.index < m_count ? v.index : v.index - m_count };
+    }
+
+    std::set<VertexDescriptor> getVertexData(const std::vector<VertexDescriptor>& vertices) const {
+      std::set<VertexDescriptor> res;
+
+      for (auto v : vertices) {
+        res.insert((*this)(v));
+      }
+
+      return res;
+    }
+
+    // adjacency
+
+    ShiftedSuccessorRange getSuccessors(VertexDescriptor v) const {
+      if (v.index < m_count) {
+        return ShiftedSuccessorRange(m_origin.getSuccessors(v), v == m_x ? m_count : 0);
+      }
+
+      return ShiftedSuccessorRange(m_origin.getSuccessors({ v.index - m_count }), m_count);
+    }
+
+    // initial and final states
+
+    VertexDescriptor getInitialState() const {
+      return m_origin.getInitialState();
+    }
+
+    bool isInitialState(VertexDescriptor v) const {
+      return v == getInitialState();
+    }
+
+    bool isFinalState(VertexDescriptor v) const {
+      if (v.index < m_count) {
+        return v == m_x && m_origin.isFinalState(v);
+      }
+
+      return m_origin.isFinalState({ v.index - m_count });
+    }
+
+  private:
+    const Graph& m_origin;
+    std::size_t m_count;
+    VertexDescriptor m_x;
+  };
+
+}
+
+#endif // DISC_CROSSING_H
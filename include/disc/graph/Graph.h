@@ -21,26 +21,40 @@
 #include <cstdint>
 
 #include <iosfwd>
+#include <limits>
+#include <memory>
 #include <set>
 #include <type_traits>
 #include <vector>
 
+#include "Bitset.h"
 #include "Range.h"
 #include "Random.h"
 #include "Matrix.h"
+#include "Sparse.h"
 
 namespace disc {
+  /*
+   * index of vertices and edges, 32 bits unless the library is built with
+   * DISC_INDEX_64 for models with more than 4 billion vertices or edges
+   */
+#ifdef DISC_INDEX_64
+  using Index = uint64_t;
+#else
+  using Index = uint32_t;
+#endif
+
   /*
    * descriptor
    */
   template<typename Tag>
   struct Descriptor {
-    uint64_t index;
+    Index index;
 
     Descriptor() = default;
 
     constexpr Descriptor(uint64_t value) noexcept
-    : index(value)
+    : index(static_cast<Index>(value))
     {
 
     }
@@ -84,7 +98,7 @@ namespace disc {
 
   using VertexDescriptor = Descriptor<VertexTag>;
 
-  constexpr VertexDescriptor InvalidVertexDescriptor = { 0xFFFFFFFF };
+  constexpr VertexDescriptor InvalidVertexDescriptor = { std::numeric_limits<Index>::max() };
 
   /*
    * edge descriptor
@@ -94,14 +108,29 @@ namespace disc {
 
   using EdgeDescriptor = Descriptor<EdgeTag>;
 
+  /*
+   * checkpoint intervals for the path counts used to generate a path, see
+   * CheckpointedPathCount
+   */
+
+  constexpr std::size_t NoCheckpoint = 0; // all the layers are kept
+  constexpr std::size_t AutoCheckpoint = std::numeric_limits<std::size_t>::max(); // square root of the length
+
+  class AlphaSnapshot;
+  class PathCountCache;
+
+  /*
+   * counting of the vertices of the paths in the approximated alpha matrix:
+   * once per path (as in the exact alpha matrix) or once per occurrence
+   */
+  enum class CoOccurrence {
+    Distinct,
+    Multiplicity,
+  };
+
   class Graph {
   public:
-    struct Vertex {
-      VertexDescriptor id;
-    };
-
     struct Edge {
-      EdgeDescriptor id;
       VertexDescriptor source;
       VertexDescriptor target;
     };
@@ -133,12 +162,26 @@ namespace disc {
     VertexDescriptor getSource(EdgeDescriptor e) const;
     VertexDescriptor getTarget(EdgeDescriptor e) const;
 
-    // out edges
+    // adjacency
+    //
+    // Once all the edges have been added, finalize() builds a compressed
+    // sparse row adjacency: the out edges of a vertex are contiguous and
+    // edges are renumbered accordingly. The graph can not be modified anymore.
+
+    void finalize();
 
-    using OutEdgeRange = IteratorRange<std::multiset<EdgeDescriptor>::const_iterator>;
+    bool isFinalized() const;
+
+    using OutEdgeRange = IntegerRange<EdgeDescriptor>;
 
     OutEdgeRange getOutEdges(VertexDescriptor v) const;
 
+    using SuccessorRange = IteratorRange<const VertexDescriptor *>;
+
+    SuccessorRange getSuccessors(VertexDescriptor v) const;
+
+    std::size_t getOutDegree(VertexDescriptor v) const;
+
     // initial and final states
 
     void setInitialState(VertexDescriptor v);
@@ -151,9 +194,7 @@ namespace disc {
 
     bool isFinalState(VertexDescriptor v) const;
 
-    using FinalStateRange = IteratorRange<std::set<VertexDescriptor>::const_iterator>;
-
-    FinalStateRange getFinalStates() const;
+    std::vector<VertexDescriptor> getFinalStates() const;
 
     // properties
 
@@ -173,17 +214,26 @@ namespace disc {
 
     std::vector<VertexDescriptor> makeRandomPath(std::size_t length, Engine& engine) const;
 
-    std::vector<VertexDescriptor> makeUnexploredPath(std::size_t length, Engine& engine, std::set<VertexDescriptor>& visited) const;
+    std::vector<VertexDescriptor> makeUnexploredPath(std::size_t length, Engine& engine, const CountedBitset& visited, std::size_t checkpoint = NoCheckpoint, PathCountCache *cache = nullptr) const;
+
+    // alpha_j (number of paths of maximum length crossing j) for all the
+    // vertices or for some vertices
+    std::vector<double> computeExactAlphaDiagonal(std::size_t length) const;
+    std::vector<double> computeExactAlphaDiagonal(std::size_t length, const std::vector<VertexDescriptor>& vertices) const;
+
+    // the state of the alpha matrices is saved in the snapshot from time to
+    // time, and resumed from the snapshot if it was saved by the same
+    // computation
 
-    Matrix<double> computeExactAlphaMatrix(std::size_t length) const;
+    SparseMatrix<double> computeExactAlphaMatrix(std::size_t length, AlphaSnapshot *snapshot = nullptr) const;
 
-    Matrix<double> computeExactNormalizedAlphaMatrix(std::size_t length) const;
+    SparseMatrix<double> computeExactNormalizedAlphaMatrix(std::size_t length, AlphaSnapshot *snapshot = nullptr) const;
 
-    Matrix<double> computeApproxAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine) const;
+    SparseMatrix<double> computeApproxAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine, CoOccurrence occurrence = CoOccurrence::Distinct, AlphaSnapshot *snapshot = nullptr) const;
 
-    Matrix<double> computeApproxNormalizedAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine) const;
+    SparseMatrix<double> computeApproxNormalizedAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine, CoOccurrence occurrence = CoOccurrence::Distinct, AlphaSnapshot *snapshot = nullptr) const;
 
-    Matrix<double> computeApproxNormalizedAlphaMatrixWithThreshold(std::size_t length, std::size_t tries, Engine& engine, double threshold) const;
+    SparseMatrix<double> computeApproxNormalizedAlphaMatrixWithThreshold(std::size_t length, std::size_t tries, Engine& engine, double threshold, CoOccurrence occurrence = CoOccurrence::Distinct, AlphaSnapshot *snapshot = nullptr) const;
 
     // import
 
@@ -191,94 +241,38 @@ namespace disc {
 
     static Graph import(std::istream& in);
 
-  private:
-    VertexDescriptor m_nextVertexId;
-    EdgeDescriptor m_nextEdgeId;
+    // parses the text format with the threads of the global pool (see
+    // Parallel.h)
+    static Graph importText(const char *filename);
 
-    std::vector<Vertex> m_vertices;
-    std::vector<Edge> m_edges;
+    // binary format
+    //
+    // The binary format contains the compressed sparse row adjacency. It is
+    // memory mapped and used in place when imported.
 
-    std::vector<std::multiset<EdgeDescriptor>> m_outEdges;
+    static Graph importBinary(const char *filename);
 
-    VertexDescriptor m_initialState;
-    std::set<VertexDescriptor> m_finalStates;
-  };
+    bool exportBinary(const char *filename) const;
 
-
-  /*
-   * DecoratedGraph
-   */
-
-  template<typename V, typename E>
-  class DecoratedGraph : public Graph {
-  public:
-    DecoratedGraph(std::size_t n)
-    : Graph(n)
-    {
-      if (n > 0) {
-        m_vertexData.reserve(n);
-        m_edgeData.reserve(n);
-      }
-    }
-
-    VertexDescriptor addVertex(V v) {
-      auto id = Graph::addVertex();
-      m_vertexData.push_back(std::move(v));
-      return id;
-    }
-
-    V& operator()(VertexDescriptor v) {
-      return m_vertexData[v.index];
-    }
-
-    const V& operator()(VertexDescriptor v) const {
-      return m_vertexData[v.index];
-    }
-
-    EdgeDescriptor addEdge(VertexDescriptor source, VertexDescriptor target, E e) {
-      auto id = Graph::addEdge(source, target);
-      m_edgeData.push_back(std::move(e));
-      return id;
-    }
-
-    E& operator()(EdgeDescriptor e) {
-      return m_edgeData[e.index];
-    }
-
-    const E& operator()(EdgeDescriptor e) const {
-      return m_edgeData[e.index];
-    }
-
-    std::set<V> getVertexData(const std::vector<VertexDescriptor>& vertices) {
-      std::set<V> res;
-
-      for (auto v : vertices) {
-        res.insert(m_vertexData[v.index]);
-      }
-
-      return res;
-    }
-
-    std::set<E> getEdgeData(const std::vector<EdgeDescriptor>& edges) {
-      std::set<E> res;
-
-      for (auto e : edges) {
-        res.insert(m_edgeData[e.index]);
-      }
-
-      return res;
-    }
+    // imports a file in the binary format or in the text format
+    static Graph importFile(const char *filename);
 
   private:
-    std::vector<V> m_vertexData;
-    std::vector<E> m_edgeData;
-  };
+    std::size_t m_vertexCount;
+    bool m_finalized;
 
-  using DerivedGraph = DecoratedGraph<VertexDescriptor, EdgeDescriptor>;
+    // edges before finalization
+    std::vector<Edge> m_edges;
 
-  DerivedGraph buildGraphCrossingOneVertex(const Graph& origin, VertexDescriptor x);
-  DerivedGraph buildGraphCrossingTwoVertices(const Graph& origin, VertexDescriptor x, VertexDescriptor y);
+    // compressed sparse row adjacency, owned or memory mapped
+    std::shared_ptr<const void> m_adjacency;
+    const uint64_t *m_offsets;
+    const VertexDescriptor *m_targets;
+    std::size_t m_edgeCount;
 
+    VertexDescriptor m_initialState;
+    Bitset m_finalStates;
+  };
 
 }
 
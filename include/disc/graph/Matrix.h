@@ -91,6 +91,12 @@ namespace disc {
       m_data.clear();
     }
 
+    void resize(std::size_t rows, std::size_t cols) {
+      m_rows = rows;
+      m_cols = cols;
+      m_data.resize(rows * cols);
+    }
+
     void assign(T value) {
       for (auto& content : m_data) {
         content = value;
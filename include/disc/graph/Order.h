@@ -0,0 +1,54 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_ORDER_H
+#define DISC_ORDER_H
+
+#include <string>
+#include <vector>
+
+#include "Graph.h"
+
+namespace disc {
+
+  /*
+   * Vertex reordering
+   *
+   * An order is a permutation of the vertices: order[v] is the original id of
+   * the vertex v of the reordered graph.
+   */
+
+  enum class VertexOrder {
+    None,
+    BreadthFirst,
+    ReverseCuthillMcKee,
+    Degree,
+  };
+
+  bool parseVertexOrder(const std::string& name, VertexOrder& order);
+
+  std::vector<VertexDescriptor> computeVertexOrder(const Graph& g, VertexOrder order);
+
+  Graph permuteGraph(const Graph& g, const std::vector<VertexDescriptor>& order);
+
+  std::vector<VertexDescriptor> restoreVertexOrder(const std::vector<VertexDescriptor>& path, const std::vector<VertexDescriptor>& order);
+
+  std::vector<double> restoreVertexOrder(const std::vector<double>& values, const std::vector<VertexDescriptor>& order);
+
+}
+
+#endif // DISC_ORDER_H
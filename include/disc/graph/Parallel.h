@@ -0,0 +1,259 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_PARALLEL_H
+#define DISC_PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace disc {
+
+  /*
+   * Barrier
+   *
+   * Blocks the threads that call wait() until all of them have arrived. The
+   * threads spin for a short time before sleeping, as the layers of the
+   * dynamic programming algorithms are short.
+   */
+  class Barrier {
+  public:
+    explicit Barrier(std::size_t threads);
+
+    void wait();
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::size_t m_threads;
+    std::atomic<std::size_t> m_waiting;
+    std::atomic<uint64_t> m_generation;
+  };
+
+  /*
+   * ThreadPool
+   *
+   * A set of persistent threads. The calling thread takes part in the work,
+   * so a pool of n threads has n - 1 workers.
+   */
+  class ThreadPool {
+  public:
+    explicit ThreadPool(std::size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t getThreadCount() const {
+      return m_workers.size() + 1;
+    }
+
+    // calls func(i) for every i in [0, threads) on different threads and
+    // returns when all the calls are done, threads must not exceed the size
+    // of the pool
+    void run(std::size_t threads, const std::function<void(std::size_t)>& func);
+
+    // true if the current thread is running a task of a pool
+    static bool isWorkerThread();
+
+  private:
+    void work(std::size_t i);
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_submit;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(std::size_t)> *m_task;
+    std::size_t m_threads;
+    std::size_t m_pending;
+    uint64_t m_generation;
+    bool m_stop;
+  };
+
+  /*
+   * WorkStealingQueue
+   *
+   * Hands out the items [0, count) to a fixed number of threads. Each thread
+   * starts with its own range of consecutive items and, when its range is
+   * empty, steals the second half of the largest remaining range.
+   */
+  class WorkStealingQueue {
+  public:
+    WorkStealingQueue(std::size_t count, std::size_t threads);
+
+    WorkStealingQueue(const WorkStealingQueue&) = delete;
+    WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+    // gets the next item of a thread, returns false when all the items have
+    // been handed out
+    bool pop(std::size_t thread, std::size_t& item);
+
+  private:
+    struct Range {
+      std::mutex mutex;
+      std::size_t begin;
+      std::size_t end;
+    };
+
+    std::vector<Range> m_ranges;
+  };
+
+  /*
+   * Progress
+   *
+   * Counts the items done by several threads and prints the count on the
+   * standard output each time a thousandth of the items is done.
+   */
+  class Progress {
+  public:
+    explicit Progress(std::size_t total);
+
+    void add(std::size_t count = 1);
+
+    // prints the final count and ends the line
+    void finish();
+
+  private:
+    std::mutex m_mutex;
+    std::size_t m_total;
+    std::atomic<std::size_t> m_done;
+    std::size_t m_printed;
+  };
+
+  // number of threads used by the parallel algorithms, 0 means the number of
+  // hardware threads
+  void setThreadCount(std::size_t threads);
+  std::size_t getThreadCount();
+
+  ThreadPool& getThreadPool();
+
+  // number of threads to use for a loop over count items
+  std::size_t getLoopThreadCount(std::size_t count);
+
+  /*
+   * Calls func(begin, end) on consecutive ranges that cover [0, count), in
+   * parallel. Nested calls from a worker run serially.
+   */
+  template<typename Func>
+  void parallelFor(std::size_t count, Func func) {
+    std::size_t threads = getLoopThreadCount(count);
+
+    if (threads == 1) {
+      func(std::size_t(0), count);
+      return;
+    }
+
+    getThreadPool().run(threads, [&](std::size_t i) {
+      func(count * i / threads, count * (i + 1) / threads);
+    });
+  }
+
+  /*
+   * Calls func(i) for every i in [0, count), the items are handed out to the
+   * threads one by one. Nested calls from a worker run serially.
+   */
+  template<typename Func>
+  void parallelForEach(std::size_t count, Func func) {
+    std::size_t threads = ThreadPool::isWorkerThread() ? 1 : std::min(getThreadCount(), count);
+
+    if (threads <= 1) {
+      for (std::size_t i = 0; i < count; ++i) {
+        func(i);
+      }
+
+      return;
+    }
+
+    std::atomic<std::size_t> next(0);
+
+    getThreadPool().run(threads, [&](std::size_t) {
+      for (std::size_t i = next++; i < count; i = next++) {
+        func(i);
+      }
+    });
+  }
+
+  /*
+   * Calls func(i, thread) for every i in [0, count), where thread identifies
+   * the calling thread in [0, getThreadCount()), for its scratch buffers. The
+   * items are handed out with a WorkStealingQueue, for loops where the cost
+   * of the items varies. Nested calls from a worker run serially.
+   */
+  template<typename Func>
+  void parallelSteal(std::size_t count, Func func) {
+    std::size_t threads = ThreadPool::isWorkerThread() ? 1 : std::min(getThreadCount(), count);
+
+    if (threads <= 1) {
+      for (std::size_t i = 0; i < count; ++i) {
+        func(i, std::size_t(0));
+      }
+
+      return;
+    }
+
+    WorkStealingQueue queue(count, threads);
+
+    getThreadPool().run(threads, [&](std::size_t thread) {
+      std::size_t i;
+
+      while (queue.pop(thread, i)) {
+        func(i, thread);
+      }
+    });
+  }
+
+  /*
+   * Calls func(begin, end, k) for every layer k in [1, layers] on consecutive
+   * ranges that cover [0, count), in parallel. All the ranges of a layer are
+   * done before the next layer starts. Nested calls from a worker run
+   * serially.
+   */
+  template<typename Func>
+  void parallelLayers(std::size_t count, std::size_t layers, Func func) {
+    std::size_t threads = getLoopThreadCount(count);
+
+    if (threads == 1) {
+      for (std::size_t k = 1; k <= layers; ++k) {
+        func(std::size_t(0), count, k);
+      }
+
+      return;
+    }
+
+    Barrier barrier(threads);
+
+    getThreadPool().run(threads, [&](std::size_t i) {
+      std::size_t begin = count * i / threads;
+      std::size_t end = count * (i + 1) / threads;
+
+      for (std::size_t k = 1; k <= layers; ++k) {
+        func(begin, end, k);
+        barrier.wait();
+      }
+    });
+  }
+
+}
+
+#endif // DISC_PARALLEL_H
@@ -0,0 +1,430 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_PATH_H
+#define DISC_PATH_H
+
+#include <cassert>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "Graph.h"
+#include "Matrix.h"
+#include "Parallel.h"
+#include "Random.h"
+
+namespace disc {
+
+  /*
+   * Path counting and uniform path generation.
+   *
+   * These algorithms work on any graph-like type providing getVertexCount(),
+   * getVertices(), getSuccessors(v), getInitialState() and isFinalState(v),
+   * i.e. a Graph or one of the crossing graph views. The vertices of a layer
+   * are shared between the threads of the global pool (see Parallel.h), the
+   * result does not depend on the number of threads.
+   */
+
+  template<typename G>
+  void computePathCountOfExactLength(const G& g, std::size_t length, Matrix<double>& paths) {
+    std::size_t count = g.getVertexCount();
+
+    paths.resize(count, length + 1);
+    paths.assign(0);
+
+    for (auto v : g.getVertices()) {
+      if (g.isFinalState(v)) {
+        paths(v.index, 0) = 1;
+      }
+    }
+
+    parallelLayers(count, length, [&](std::size_t begin, std::size_t end, std::size_t k) {
+      for (std::size_t i = begin; i < end; ++i) {
+        double pathCount = 0;
+
+        for (auto next : g.getSuccessors({ i })) {
+          pathCount += paths(next.index, k - 1);
+        }
+
+        paths(i, k) = pathCount;
+      }
+    });
+  }
+
+  template<typename G>
+  Matrix<double> computePathCountOfExactLength(const G& g, std::size_t length) {
+    Matrix<double> paths;
+    computePathCountOfExactLength(g, length, paths);
+    return paths;
+  }
+
+  template<typename G>
+  Matrix<double> computePathCountOfMaximumLength(const G& g, std::size_t length) {
+    auto paths = computePathCountOfExactLength(g, length);
+
+    parallelFor(paths.getRows(), [&](std::size_t begin, std::size_t end) {
+      for (std::size_t j = 1; j < paths.getCols(); ++j) {
+        for (std::size_t i = begin; i < end; ++i) {
+          paths(i, j) += paths(i, j - 1);
+        }
+      }
+    });
+
+    return paths;
+  }
+
+  // only the last two layers are kept in the paths matrix, that is a
+  // workspace that can be reused across calls
+  template<typename G>
+  double countPathOfMaximumLengthFromInitialState(const G& g, std::size_t length, Matrix<double>& paths) {
+    std::size_t count = g.getVertexCount();
+    std::size_t init = g.getInitialState().index;
+
+    paths.resize(count, 2);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      paths(i, 0) = g.isFinalState({ i }) ? 1 : 0;
+    }
+
+    double total = paths(init, 0);
+
+    parallelLayers(count, length, [&](std::size_t begin, std::size_t end, std::size_t k) {
+      for (std::size_t i = begin; i < end; ++i) {
+        double pathCount = 0;
+
+        for (auto next : g.getSuccessors({ i })) {
+          pathCount += paths(next.index, (k - 1) % 2);
+        }
+
+        paths(i, k % 2) = pathCount;
+      }
+
+      if (begin <= init && init < end) {
+        total += paths(init, k % 2);
+      }
+    });
+
+    return total;
+  }
+
+  template<typename G>
+  double countPathOfMaximumLengthFromInitialState(const G& g, std::size_t length) {
+    Matrix<double> paths;
+    return countPathOfMaximumLengthFromInitialState(g, length, paths);
+  }
+
+  /*
+   * Batched path counting: computes batch independent path counts on the same
+   * graph at once, so that every edge is read once per layer for all of them.
+   * The counts are stored vertex-major: counts[(s * n + v) * batch + b] is the
+   * count b of the vertex v for the length k, with s = k % layers. Only the
+   * last layers are kept, layers is 2 when only the counts of the last length
+   * are needed and length + 1 when all the counts are needed.
+   *
+   * The counts of a vertex are computed with the same recurrence as the
+   * scalar version, starting from zero for the length 0. Then update(v, k,
+   * counts) is called with the counts of v for the length k and can modify
+   * them (to set the final states or to pin the counts of some vertices).
+   */
+  template<typename G, typename Update>
+  void computeBatchedPathCountOfExactLength(const G& g, std::size_t length, std::size_t batch, std::size_t layers, std::vector<double>& counts, Update update) {
+    assert(layers >= std::min(length + 1, std::size_t(2)));
+    std::size_t count = g.getVertexCount();
+    std::size_t stride = count * batch;
+
+    counts.resize(layers * stride);
+
+    parallelFor(count, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i) {
+        double *out = counts.data() + i * batch;
+        std::fill(out, out + batch, 0.0);
+        update(VertexDescriptor(i), std::size_t(0), out);
+      }
+    });
+
+    parallelLayers(count, length, [&](std::size_t begin, std::size_t end, std::size_t k) {
+      const double *prev = counts.data() + ((k - 1) % layers) * stride;
+      double *curr = counts.data() + (k % layers) * stride;
+
+      for (std::size_t i = begin; i < end; ++i) {
+        double *out = curr + i * batch;
+        std::fill(out, out + batch, 0.0);
+
+        for (auto next : g.getSuccessors({ i })) {
+          const double *in = prev + next.index * batch;
+
+          for (std::size_t b = 0; b < batch; ++b) {
+            out[b] += in[b];
+          }
+        }
+
+        update(VertexDescriptor(i), k, out);
+      }
+    });
+  }
+
+  // all the layers are kept and summed
+  template<typename G, typename Update>
+  void computeBatchedPathCountOfMaximumLength(const G& g, std::size_t length, std::size_t batch, std::vector<double>& counts, Update update) {
+    computeBatchedPathCountOfExactLength(g, length, batch, length + 1, counts, update);
+
+    std::size_t stride = g.getVertexCount() * batch;
+
+    parallelFor(g.getVertexCount(), [&](std::size_t begin, std::size_t end) {
+      for (std::size_t k = 1; k <= length; ++k) {
+        for (std::size_t i = begin * batch; i < end * batch; ++i) {
+          counts[k * stride + i] += counts[(k - 1) * stride + i];
+        }
+      }
+    });
+  }
+
+  /*
+   * PathSampler
+   *
+   * Generates uniform paths from the path counts of maximum length of a
+   * graph. The next vertex is chosen by a binary search over the cumulative
+   * counts of the successors, in buffers that are reused so that no memory
+   * is allocated once the buffers are large enough. Paths can be a
+   * Matrix<double> or any type with the same interface.
+   */
+  template<typename G, typename Paths = Matrix<double>>
+  class PathSampler {
+  public:
+    PathSampler(const G& g, std::size_t length, const Paths& paths)
+    : m_graph(g)
+    , m_length(length)
+    , m_paths(paths)
+    {
+      assert(paths.getRows() == g.getVertexCount());
+      assert(paths.getCols() == length + 1);
+    }
+
+    // generates a path in the buffer
+    void sample(Engine& engine, std::vector<VertexDescriptor>& path) {
+      path.clear();
+
+      VertexDescriptor current = m_graph.getInitialState();
+      path.push_back(current);
+
+      for (auto k = m_length; k > 0; --k) {
+        m_vertices.clear();
+        m_cumulative.clear();
+
+        double sum = 0;
+
+        for (auto next : m_graph.getSuccessors(current)) {
+          double weight = m_paths(next.index, k - 1);
+
+          if (weight > 0) {
+            sum += weight;
+            m_vertices.push_back(next);
+            m_cumulative.push_back(sum);
+          }
+        }
+
+        if (m_vertices.empty()) {
+          // no more candidates, we are at a final state
+          break;
+        }
+
+        std::size_t index;
+
+        if (sum <= std::numeric_limits<double>::epsilon()) {
+          std::uniform_int_distribution<std::size_t> dist(0, m_vertices.size() - 1);
+          index = dist(engine);
+        } else {
+          std::uniform_real_distribution<double> dist(0.0, sum);
+          auto it = std::upper_bound(m_cumulative.begin(), m_cumulative.end(), dist(engine));
+          index = std::min(static_cast<std::size_t>(it - m_cumulative.begin()), m_vertices.size() - 1);
+        }
+
+        current = m_vertices[index];
+        path.push_back(current);
+      }
+
+      assert(m_graph.isFinalState(current));
+    }
+
+    // generates count paths in the buffers
+    void sample(std::size_t count, Engine& engine, std::vector<std::vector<VertexDescriptor>>& paths) {
+      paths.resize(count);
+
+      for (auto& path : paths) {
+        sample(engine, path);
+      }
+    }
+
+  private:
+    const G& m_graph;
+    std::size_t m_length;
+    const Paths& m_paths;
+    std::vector<VertexDescriptor> m_vertices;
+    std::vector<double> m_cumulative;
+  };
+
+  template<typename G, typename Paths>
+  std::vector<VertexDescriptor> makeUniformPath(const G& g, std::size_t length, Engine& engine, const Paths& paths) {
+    PathSampler<G, Paths> sampler(g, length, paths);
+    std::vector<VertexDescriptor> path;
+    sampler.sample(engine, path);
+    return path;
+  }
+
+  /*
+   * CheckpointedPathCount
+   *
+   * The same path counts as computePathCountOfMaximumLength, with the same
+   * values, but only the layers that are multiple of an interval are kept
+   * (the exact and the cumulative counts). When a layer is accessed, its
+   * segment is recomputed from the checkpoint below it, so that the memory
+   * is n * (2 * length / interval + interval) doubles instead of
+   * n * (length + 1). makeUniformPath accesses the layers in decreasing order
+   * so each segment is computed once per path, which costs one more dynamic
+   * programming per path.
+   *
+   * The access to the counts is not thread-safe.
+   */
+  template<typename G>
+  class CheckpointedPathCount {
+  public:
+    CheckpointedPathCount(const G& g, std::size_t length, std::size_t interval = AutoCheckpoint)
+    : m_graph(g)
+    , m_length(length)
+    , m_interval(interval)
+    , m_loaded(NotLoaded)
+    {
+      if (m_interval == NoCheckpoint || m_interval == AutoCheckpoint) {
+        m_interval = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(length + 1))));
+      }
+
+      std::size_t count = g.getVertexCount();
+      std::size_t checkpoints = length / m_interval + 1;
+
+      m_checkpointExact.resize(count, checkpoints);
+      m_checkpointMaximum.resize(count, checkpoints);
+      m_exact.resize(count, 2);
+      m_maximum.resize(count, 1);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        double pathCount = g.isFinalState({ i }) ? 1 : 0;
+        m_exact(i, 0) = m_checkpointExact(i, 0) = pathCount;
+        m_maximum(i, 0) = m_checkpointMaximum(i, 0) = pathCount;
+      }
+
+      compute(0, length, [this](std::size_t i, std::size_t k) {
+        if (k % m_interval == 0) {
+          m_checkpointExact(i, k / m_interval) = m_exact(i, k % 2);
+          m_checkpointMaximum(i, k / m_interval) = m_maximum(i, 0);
+        }
+      });
+    }
+
+    std::size_t getRows() const {
+      return m_graph.getVertexCount();
+    }
+
+    std::size_t getCols() const {
+      return m_length + 1;
+    }
+
+    double operator()(std::size_t row, std::size_t col) const {
+      assert(col <= m_length);
+      std::size_t segment = col / m_interval;
+
+      if (segment != m_loaded) {
+        load(segment);
+      }
+
+      return m_segment(row, col - segment * m_interval);
+    }
+
+  private:
+    static constexpr std::size_t NotLoaded = std::numeric_limits<std::size_t>::max();
+
+    void load(std::size_t segment) const {
+      std::size_t count = m_graph.getVertexCount();
+      std::size_t first = segment * m_interval;
+      std::size_t last = std::min(first + m_interval - 1, m_length);
+
+      m_segment.resize(count, m_interval);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        m_exact(i, first % 2) = m_checkpointExact(i, segment);
+        m_maximum(i, 0) = m_segment(i, 0) = m_checkpointMaximum(i, segment);
+      }
+
+      compute(first, last, [this, first](std::size_t i, std::size_t k) {
+        m_segment(i, k - first) = m_maximum(i, 0);
+      });
+
+      m_loaded = segment;
+    }
+
+    // computes the layers from first + 1 to last, the layer first being in
+    // the buffers, store(i, k) is called when the layer k of i is computed
+    template<typename Store>
+    void compute(std::size_t first, std::size_t last, Store store) const {
+      parallelLayers(m_graph.getVertexCount(), last - first, [&](std::size_t begin, std::size_t end, std::size_t step) {
+        std::size_t k = first + step;
+
+        for (std::size_t i = begin; i < end; ++i) {
+          double pathCount = 0;
+
+          for (auto next : m_graph.getSuccessors({ i })) {
+            pathCount += m_exact(next.index, (k - 1) % 2);
+          }
+
+          m_exact(i, k % 2) = pathCount;
+          m_maximum(i, 0) += pathCount;
+          store(i, k);
+        }
+      });
+    }
+
+  private:
+    const G& m_graph;
+    std::size_t m_length;
+    std::size_t m_interval;
+    Matrix<double> m_checkpointExact;
+    Matrix<double> m_checkpointMaximum;
+    mutable Matrix<double> m_exact;
+    mutable Matrix<double> m_maximum;
+    mutable Matrix<double> m_segment;
+    mutable std::size_t m_loaded;
+  };
+
+  // generates a single path, with checkpointed path counts unless checkpoint
+  // is NoCheckpoint
+  template<typename G>
+  std::vector<VertexDescriptor> makeSingleUniformPath(const G& g, std::size_t length, Engine& engine, std::size_t checkpoint) {
+    if (checkpoint == NoCheckpoint) {
+      auto paths = computePathCountOfMaximumLength(g, length);
+      return makeUniformPath(g, length, engine, paths);
+    }
+
+    CheckpointedPathCount<G> paths(g, length, checkpoint);
+    return makeUniformPath(g, length, engine, paths);
+  }
+
+}
+
+#endif // DISC_PATH_H
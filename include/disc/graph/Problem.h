@@ -18,13 +18,73 @@
 #ifndef DISC_PROBLEM_H
 #define DISC_PROBLEM_H
 
+#include <cstddef>
 #include <vector>
 
 #include "Matrix.h"
+#include "Sparse.h"
 
 namespace disc {
 
-  std::vector<double> computePii(const Matrix<double>& coeffs, const char *filename);
+  /*
+   * The problem is to find the distribution pi that maximizes the minimum
+   * probability p_min = min_i sum_j coeffs(i, j) * pi_j.
+   *
+   * The reduction merges the identical columns (their pi mass is shared
+   * equally when the solution is expanded), keeps one of the identical rows,
+   * removes the columns that are dominated by another column (their pi is
+   * zero) and the rows that dominate another row (their constraint is
+   * implied). The reduced problem has the same p_min.
+   */
+
+  constexpr std::size_t NoReducedColumn = static_cast<std::size_t>(-1);
+
+  struct MaxMinReduction {
+    SparseMatrix<double> coeffs; // the reduced problem
+    std::vector<std::size_t> columns; // the reduced column of each column, or NoReducedColumn
+    std::vector<std::size_t> counts; // the number of columns merged in each reduced column
+  };
+
+  MaxMinReduction reduceMaxMinProblem(const SparseMatrix<double>& coeffs);
+
+  // the pi of the reduced problem, the mass of the removed columns is lost
+  std::vector<double> reduceMaxMinSolution(const MaxMinReduction& reduction, const std::vector<double>& pi);
+
+  std::vector<double> expandMaxMinSolution(const MaxMinReduction& reduction, const std::vector<double>& pi);
+
+  enum class LpMethod {
+    Simplex,
+    InteriorPoint,
+    MirrorProx, // native first order method, see below
+  };
+
+  struct LpOptions {
+    LpMethod method = LpMethod::Simplex;
+    bool presolve = false;
+    double timeLimit = 20 * 60; // in seconds, for the simplex and the mirror prox, 0 for no limit
+    std::vector<double> start; // pi of a previous run for a warm start, or empty
+    bool reduce = true; // solve the reduced problem
+    double accuracy = 1e-3; // for the mirror prox, relative gap between the bounds of p_min
+    std::size_t iterations = 100000; // for the mirror prox
+  };
+
+  /*
+   * The mirror prox solves the problem as a matrix game between pi and a
+   * distribution on the rows, with multiplicative updates of both. It only
+   * needs matrix-vector products, computed in parallel, and stops when the
+   * lower bound of p_min given by the average pi and the upper bound given
+   * by the average distribution on the rows are close enough.
+   */
+
+  // returns the optimal pi, or the best feasible pi that was found if the LP
+  // is not solved (time limit, numerical problems). With a warm start, the
+  // basis of the simplex is built from the start and the presolver is not
+  // used. The LP is written in the file, if any, except for the mirror prox.
+  std::vector<double> computePii(const SparseMatrix<double>& coeffs, const char *filename, const LpOptions& options = LpOptions());
+
+  inline std::vector<double> computePii(const Matrix<double>& coeffs, const char *filename, const LpOptions& options = LpOptions()) {
+    return computePii(SparseMatrix<double>(coeffs), filename, options);
+  }
 
 }
 
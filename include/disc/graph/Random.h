@@ -18,6 +18,7 @@
 #ifndef DISC_RANDOM_H
 #define DISC_RANDOM_H
 
+#include <cstdint>
 #include <random>
 
 namespace disc {
@@ -26,6 +27,10 @@ namespace disc {
 
   Engine getCorrectlyInitializedEngine();
 
+  // engine for one of the independent streams of a seed, so that a
+  // computation split between threads does not depend on the threads
+  Engine getStreamEngine(uint64_t seed, uint64_t stream);
+
 }
 
 #endif // DISC_RANDOM_H
@@ -0,0 +1,80 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_SNAPSHOT_H
+#define DISC_SNAPSHOT_H
+
+#include <cstdint>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Random.h"
+#include "Sparse.h"
+
+namespace disc {
+
+  /*
+   * State of an alpha matrix computation: the parts of the matrix that are
+   * done, column by column, the progress of the computation that is not
+   * column by column (the chunks of paths of the approximated alpha matrix)
+   * and the state of the random engine.
+   */
+  struct AlphaState {
+    uint64_t seed = 0;
+    uint64_t progress = 0;
+    Engine engine;
+    std::vector<SparseMatrix<double>> parts;
+  };
+
+  /*
+   * AlphaSnapshot
+   *
+   * File where a long alpha matrix computation saves its state from time to
+   * time, so that it can be resumed after an interruption. A state is only
+   * resumed by the same computation on the same graph, identified by a
+   * signature.
+   */
+  class AlphaSnapshot {
+  public:
+    // the interval between two saves is in seconds
+    AlphaSnapshot(std::string filename, double interval);
+
+    const std::string& getFilename() const {
+      return m_filename;
+    }
+
+    // returns false if there is no state of this computation in the file
+    bool load(const std::string& signature, AlphaState& state) const;
+
+    // true if the interval has elapsed since the last save
+    bool isDue() const;
+
+    // the state is written in a temporary file that replaces the file, so
+    // that an interruption never leaves a partial state
+    bool save(const std::string& signature, const AlphaState& state);
+
+  private:
+    std::string m_filename;
+    std::chrono::duration<double> m_interval;
+    std::chrono::steady_clock::time_point m_last;
+  };
+
+}
+
+#endif // DISC_SNAPSHOT_H
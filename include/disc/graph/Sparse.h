@@ -0,0 +1,250 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DISC_SPARSE_H
+#define DISC_SPARSE_H
+
+#include <cassert>
+#include <cstdint>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "Matrix.h"
+
+namespace disc {
+
+  /*
+   * Sparse matrix in compressed column format: the entries of column j are
+   * at positions [getColumnBegin(j), getColumnEnd(j)), sorted by row. The
+   * entries that are not stored are zero.
+   *
+   * The matrix is built column by column with addColumn() and addEntry().
+   */
+  template<class T>
+  class SparseMatrix {
+  public:
+    // rows are stored on 32 bits, a larger matrix would not fit anyway
+    using RowIndex = uint32_t;
+
+    SparseMatrix()
+    : m_rows(0)
+    , m_offsets(1, 0)
+    {
+
+    }
+
+    explicit SparseMatrix(std::size_t rows)
+    : m_rows(rows)
+    , m_offsets(1, 0)
+    {
+      assert(rows <= std::numeric_limits<RowIndex>::max());
+    }
+
+    SparseMatrix(std::size_t rows, std::vector<std::size_t> offsets, std::vector<RowIndex> indices, std::vector<T> values)
+    : m_rows(rows)
+    , m_offsets(std::move(offsets))
+    , m_indices(std::move(indices))
+    , m_values(std::move(values))
+    {
+      assert(!m_offsets.empty());
+      assert(m_offsets.back() == m_indices.size());
+      assert(m_indices.size() == m_values.size());
+    }
+
+    // keeps the nonzero entries of a dense matrix
+    explicit SparseMatrix(const Matrix<T>& dense)
+    : SparseMatrix(dense.getRows())
+    {
+      for (std::size_t col = 0; col < dense.getCols(); ++col) {
+        addColumn();
+
+        for (std::size_t row = 0; row < dense.getRows(); ++row) {
+          if (dense(row, col) != T()) {
+            addEntry(row, dense(row, col));
+          }
+        }
+      }
+    }
+
+    SparseMatrix(const SparseMatrix&) = default;
+    SparseMatrix(SparseMatrix&&) = default;
+
+    SparseMatrix& operator=(const SparseMatrix&) = default;
+    SparseMatrix& operator=(SparseMatrix&&) = default;
+
+    // element access
+
+    T operator()(std::size_t row, std::size_t col) const {
+      assert(row < m_rows);
+      assert(col < getCols());
+      auto first = m_indices.begin() + m_offsets[col];
+      auto last = m_indices.begin() + m_offsets[col + 1];
+      auto it = std::lower_bound(first, last, static_cast<RowIndex>(row));
+
+      if (it == last || *it != row) {
+        return T();
+      }
+
+      return m_values[it - m_indices.begin()];
+    }
+
+    std::size_t getColumnBegin(std::size_t col) const {
+      assert(col < getCols());
+      return m_offsets[col];
+    }
+
+    std::size_t getColumnEnd(std::size_t col) const {
+      assert(col < getCols());
+      return m_offsets[col + 1];
+    }
+
+    std::size_t getRow(std::size_t entry) const {
+      assert(entry < m_indices.size());
+      return m_indices[entry];
+    }
+
+    T& getValue(std::size_t entry) {
+      assert(entry < m_values.size());
+      return m_values[entry];
+    }
+
+    const T& getValue(std::size_t entry) const {
+      assert(entry < m_values.size());
+      return m_values[entry];
+    }
+
+    // raw storage, for the serialization
+
+    const std::size_t *getOffsetData() const {
+      return m_offsets.data();
+    }
+
+    const RowIndex *getRowData() const {
+      return m_indices.data();
+    }
+
+    const T *getValueData() const {
+      return m_values.data();
+    }
+
+    // capacity
+
+    bool isEmpty() const {
+      return m_values.empty();
+    }
+
+    std::size_t getRows() const {
+      return m_rows;
+    }
+
+    std::size_t getCols() const {
+      return m_offsets.size() - 1;
+    }
+
+    std::size_t getNonZeroCount() const {
+      return m_values.size();
+    }
+
+    // modifiers
+
+    void clear() {
+      m_offsets.assign(1, 0);
+      m_indices.clear();
+      m_values.clear();
+    }
+
+    void reserve(std::size_t entries) {
+      m_indices.reserve(entries);
+      m_values.reserve(entries);
+    }
+
+    void addColumn() {
+      m_offsets.push_back(m_values.size());
+    }
+
+    // the entries of the last column must be added by increasing row
+    void addEntry(std::size_t row, T value) {
+      assert(getCols() > 0);
+      assert(row < m_rows);
+      assert(m_offsets[getCols() - 1] == m_values.size() || m_indices.back() < row);
+      m_indices.push_back(static_cast<RowIndex>(row));
+      m_values.push_back(value);
+      ++m_offsets.back();
+    }
+
+    void swap(SparseMatrix& other) {
+      std::swap(m_rows, other.m_rows);
+      std::swap(m_offsets, other.m_offsets);
+      std::swap(m_indices, other.m_indices);
+      std::swap(m_values, other.m_values);
+    }
+
+  private:
+    std::size_t m_rows;
+    std::vector<std::size_t> m_offsets;
+    std::vector<RowIndex> m_indices;
+    std::vector<T> m_values;
+  };
+
+
+  template<typename T>
+  std::ostream& operator<<(std::ostream& o, const SparseMatrix<T>& m) {
+    for (std::size_t y = 0; y < m.getCols(); ++y) {
+      for (std::size_t k = m.getColumnBegin(y); k < m.getColumnEnd(y); ++k) {
+        o << ' ' << m.getRow(k) << ':' << m.getValue(k);
+      }
+      o << '\n';
+    }
+
+    return o;
+  }
+
+  // the columns of the transpose are the rows of the matrix
+  template<typename T>
+  SparseMatrix<T> matrixTranspose(const SparseMatrix<T>& m) {
+    std::vector<std::size_t> offsets(m.getRows() + 1, 0);
+
+    for (std::size_t k = 0; k < m.getNonZeroCount(); ++k) {
+      ++offsets[m.getRow(k) + 1];
+    }
+
+    for (std::size_t i = 0; i < m.getRows(); ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<typename SparseMatrix<T>::RowIndex> indices(m.getNonZeroCount());
+    std::vector<T> values(m.getNonZeroCount());
+    std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+
+    for (std::size_t j = 0; j < m.getCols(); ++j) {
+      for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+        std::size_t entry = next[m.getRow(k)]++;
+        indices[entry] = static_cast<typename SparseMatrix<T>::RowIndex>(j);
+        values[entry] = m.getValue(k);
+      }
+    }
+
+    return SparseMatrix<T>(m.getCols(), std::move(offsets), std::move(indices), std::move(values));
+  }
+
+}
+
+#endif // DISC_SPARSE_H
@@ -0,0 +1,171 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <disc/graph/Cache.h>
+
+#include <cassert>
+
+#include <disc/graph/Path.h>
+
+namespace disc {
+
+  PathCountCache::PathCountCache(std::size_t budget)
+  : m_budget(budget)
+  , m_size(0)
+  , m_hits(0)
+  , m_misses(0)
+  , m_graph(nullptr)
+  {
+  }
+
+  namespace {
+
+    // the path counts of the first copy of the graph crossing one vertex,
+    // computed like computePathCountOfMaximumLength so that the counts are
+    // the same, with only two layers of exact counts for the whole graph
+    Matrix<double> computeCrossingPathCount(const GraphCrossingOneVertex& derived, std::size_t length) {
+      std::size_t count = derived.getOrigin().getVertexCount();
+
+      Matrix<double> paths(count, length + 1);
+      Matrix<double> exact(2 * count, 2);
+
+      for (std::size_t i = 0; i < 2 * count; ++i) {
+        exact(i, 0) = derived.isFinalState({ i }) ? 1 : 0;
+
+        if (i < count) {
+          paths(i, 0) = exact(i, 0);
+        }
+      }
+
+      parallelLayers(2 * count, length, [&](std::size_t begin, std::size_t end, std::size_t k) {
+        for (std::size_t i = begin; i < end; ++i) {
+          double pathCount = 0;
+
+          for (auto next : derived.getSuccessors({ i })) {
+            pathCount += exact(next.index, (k - 1) % 2);
+          }
+
+          exact(i, k % 2) = pathCount;
+
+          if (i < count) {
+            paths(i, k) = paths(i, k - 1) + pathCount;
+          }
+        }
+      });
+
+      return paths;
+    }
+
+  }
+
+  CachedPathCount PathCountCache::getPathCount(const GraphCrossingOneVertex& derived, std::size_t length) {
+    Key key(derived.getCrossingVertex().index, length);
+    std::size_t size = derived.getOrigin().getVertexCount() * (length + 1) * sizeof(double);
+    std::shared_ptr<const Matrix<double>> origin;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      assert(m_graph == nullptr || m_graph == &derived.getOrigin());
+      m_graph = &derived.getOrigin();
+
+      auto it = m_index.find(key);
+
+      if (it != m_index.end()) {
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return CachedPathCount(it->second->paths, m_origins.at(length).paths);
+      }
+
+      // the counts that can never be cached, with the counts of the origin
+      // graph, are not misses
+      if (2 * size > m_budget) {
+        return CachedPathCount();
+      }
+
+      ++m_misses;
+
+      auto originIt = m_origins.find(length);
+
+      if (originIt != m_origins.end()) {
+        origin = originIt->second.paths;
+      }
+    }
+
+    if (!origin) {
+      origin = std::make_shared<const Matrix<double>>(computePathCountOfMaximumLength(derived.getOrigin(), length));
+    }
+
+    auto paths = std::make_shared<const Matrix<double>>(computeCrossingPathCount(derived, length));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // another thread may have added the counts in the meantime
+    auto it = m_index.find(key);
+
+    if (it != m_index.end()) {
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return CachedPathCount(it->second->paths, m_origins.at(length).paths);
+    }
+
+    // the counts of the origin graph may be evicted with the last entry of
+    // this length, so they are counted until they are in the cache
+    while (!m_entries.empty() && m_size + size + (m_origins.count(length) == 0 ? size : 0) > m_budget) {
+      evict();
+    }
+
+    auto originIt = m_origins.find(length);
+
+    if (originIt == m_origins.end()) {
+      originIt = m_origins.emplace(length, Origin{ origin, size, 0 }).first;
+      m_size += size;
+    }
+
+    ++originIt->second.references;
+    m_entries.push_front({ key, size, paths });
+    m_index.emplace(key, m_entries.begin());
+    m_size += size;
+
+    return CachedPathCount(paths, originIt->second.paths);
+  }
+
+  void PathCountCache::evict() {
+    auto& entry = m_entries.back();
+    auto& origin = m_origins.at(entry.key.second);
+
+    if (--origin.references == 0) {
+      m_size -= origin.size;
+      m_origins.erase(entry.key.second);
+    }
+
+    m_size -= entry.size;
+    m_index.erase(entry.key);
+    m_entries.pop_back();
+  }
+
+  std::vector<VertexDescriptor> makeCrossingUniformPath(const GraphCrossingOneVertex& derived, std::size_t length, Engine& engine, std::size_t checkpoint, PathCountCache *cache) {
+    if (cache != nullptr && checkpoint == NoCheckpoint) {
+      auto paths = cache->getPathCount(derived, length);
+
+      if (paths) {
+        return makeUniformPath(derived, length, engine, paths);
+      }
+    }
+
+    return makeSingleUniformPath(derived, length, engine, checkpoint);
+  }
+
+}
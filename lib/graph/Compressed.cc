@@ -0,0 +1,78 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <disc/graph/Compressed.h>
+
+#include <algorithm>
+
+namespace disc {
+
+  namespace {
+
+    void encode(std::vector<uint8_t>& data, uint64_t value) {
+      while (value >= 0x80) {
+        data.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+      }
+
+      data.push_back(static_cast<uint8_t>(value));
+    }
+
+  }
+
+  CompressedGraph::CompressedGraph(const Graph& g)
+  : m_vertexCount(g.getVertexCount())
+  , m_edgeCount(g.getEdgeCount())
+  , m_initialState(g.getInitialState())
+  , m_finalStates(g.getVertexCount())
+  {
+    m_offsets.reserve(m_vertexCount + 1);
+    m_offsets.push_back(0);
+
+    std::vector<uint64_t> successors;
+
+    for (auto v : g.getVertices()) {
+      successors.clear();
+
+      for (auto next : g.getSuccessors(v)) {
+        successors.push_back(next.index);
+      }
+
+      std::sort(successors.begin(), successors.end());
+
+      uint64_t previous = 0;
+
+      for (auto next : successors) {
+        encode(m_data, next - previous);
+        previous = next;
+      }
+
+      m_offsets.push_back(m_data.size());
+
+      if (g.isFinalState(v)) {
+        m_finalStates.set(v.index);
+      }
+    }
+
+    m_data.shrink_to_fit();
+  }
+
+  std::size_t CompressedGraph::getMemorySize() const {
+    return m_offsets.size() * sizeof(uint64_t) + m_data.size();
+  }
+
+}
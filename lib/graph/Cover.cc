@@ -19,12 +19,18 @@
 
 namespace disc {
 
+  uint64_t makeCoverSeed(Engine& engine) {
+    uint64_t high = engine();
+    uint64_t low = engine();
+    return (high << 32) | low;
+  }
+
   Metrics coverGraphOnceRandom(const Graph& g, Engine& engine, std::size_t length) {
     Metrics res;
 
     std::size_t count = g.getVertexCount();
 
-    std::set<VertexDescriptor> visited;
+    CountedBitset visited(count);
 
     std::size_t iterations = 0;
 
@@ -33,34 +39,38 @@ namespace disc {
     bool has_95 = false;
     bool has_99 = false;
 
-    while (visited.size() != count) {
+    while (!visited.isFull()) {
       auto path = g.makeRandomPath(length, engine);
-      visited.insert(path.begin(), path.end());
+      std::size_t newlyVisited = 0;
+
+      for (auto v : path) {
+        newlyVisited += visited.insert(v.index) ? 1 : 0;
+      }
 
       ++iterations;
 
-      if (!has_50 && 2 * visited.size() >= count) {
+      if (newlyVisited == 0) {
+        continue;
+      }
+
+      if (!has_50 && 2 * visited.getCount() >= count) {
         has_50 = true;
         res.covered_50 = iterations;
-        std::cout << '5' << std::flush;
       }
 
-      if (!has_90 && 10 * visited.size() >= 9 * count) {
+      if (!has_90 && 10 * visited.getCount() >= 9 * count) {
         has_90 = true;
         res.covered_90 = iterations;
-        std::cout << '9' << std::flush;
       }
 
-      if (!has_95 && 20 * visited.size() >= 19 * count) {
+      if (!has_95 && 20 * visited.getCount() >= 19 * count) {
         has_95 = true;
         res.covered_95 = iterations;
-        std::cout << '=' << std::flush;
       }
 
-      if (!has_99 && 100 * visited.size() >= 99 * count) {
+      if (!has_99 && 100 * visited.getCount() >= 99 * count) {
         has_99 = true;
         res.covered_99 = iterations;
-        std::cout << '-' << std::flush;
       }
     }
 
@@ -69,24 +79,17 @@ namespace disc {
   }
 
   std::vector<Metrics> coverGraphMultipleRandom(const Graph& g, Engine& engine, std::size_t length, std::size_t tries) {
-    std::vector<Metrics> results;
-
-    for (std::size_t i = 0; i < tries; ++i) {
-      auto m = coverGraphOnceRandom(g, engine, length);
-      std::cout << '.' << std::flush;
-      results.push_back(m);
-    }
-
-    std::cout << '\n';
-    return results;
+    return coverGraphTries(engine, tries, [&](Engine& local) {
+      return coverGraphOnceRandom(g, local, length);
+    });
   }
 
-  Metrics coverGraphOnceUnexplored(const Graph& g, Engine& engine, std::size_t length) {
+  Metrics coverGraphOnceUnexplored(const Graph& g, Engine& engine, std::size_t length, std::size_t checkpoint, PathCountCache *cache) {
     Metrics res;
 
     std::size_t count = g.getVertexCount();
 
-    std::set<VertexDescriptor> visited;
+    CountedBitset visited(count);
 
     std::size_t iterations = 0;
 
@@ -95,34 +98,38 @@ namespace disc {
     bool has_95 = false;
     bool has_99 = false;
 
-    while (visited.size() != count) {
-      auto path = g.makeUnexploredPath(length, engine, visited);
-      visited.insert(path.begin(), path.end());
+    while (!visited.isFull()) {
+      auto path = g.makeUnexploredPath(length, engine, visited, checkpoint, cache);
+      std::size_t newlyVisited = 0;
+
+      for (auto v : path) {
+        newlyVisited += visited.insert(v.index) ? 1 : 0;
+      }
 
       ++iterations;
 
-      if (!has_50 && 2 * visited.size() >= count) {
+      if (newlyVisited == 0) {
+        continue;
+      }
+
+      if (!has_50 && 2 * visited.getCount() >= count) {
         has_50 = true;
         res.covered_50 = iterations;
-        std::cout << '5' << std::flush;
       }
 
-      if (!has_90 && 10 * visited.size() >= 9 * count) {
+      if (!has_90 && 10 * visited.getCount() >= 9 * count) {
         has_90 = true;
         res.covered_90 = iterations;
-        std::cout << '9' << std::flush;
       }
 
-      if (!has_95 && 20 * visited.size() >= 19 * count) {
+      if (!has_95 && 20 * visited.getCount() >= 19 * count) {
         has_95 = true;
         res.covered_95 = iterations;
-        std::cout << '=' << std::flush;
       }
 
-      if (!has_99 && 100 * visited.size() >= 99 * count) {
+      if (!has_99 && 100 * visited.getCount() >= 99 * count) {
         has_99 = true;
         res.covered_99 = iterations;
-        std::cout << '-' << std::flush;
       }
     }
 
@@ -130,17 +137,10 @@ namespace disc {
     return res;
   }
 
-  std::vector<Metrics> coverGraphMultipleUnexplored(const Graph& g, Engine& engine, std::size_t length, std::size_t tries) {
-    std::vector<Metrics> results;
-
-    for (std::size_t i = 0; i < tries; ++i) {
-      auto m = coverGraphOnceUnexplored(g, engine, length);
-      std::cout << '.' << std::flush;
-      results.push_back(m);
-    }
-
-    std::cout << '\n';
-    return results;
+  std::vector<Metrics> coverGraphMultipleUnexplored(const Graph& g, Engine& engine, std::size_t length, std::size_t tries, std::size_t checkpoint, PathCountCache *cache) {
+    return coverGraphTries(engine, tries, [&](Engine& local) {
+      return coverGraphOnceUnexplored(g, local, length, checkpoint, cache);
+    });
   }
 
 }
@@ -19,65 +19,328 @@
 
 #include <cassert>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <deque>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+
+#include <disc/graph/Cache.h>
+#include <disc/graph/Crossing.h>
+#include <disc/graph/Parallel.h>
+#include <disc/graph/Path.h>
+#include <disc/graph/Snapshot.h>
 
 namespace disc {
 
+  namespace {
+
+    // number of vertices handled at once for the diagonal of the exact alpha
+    // matrix, and size of the blocks of pairs for the rest of the matrix
+    constexpr std::size_t AlphaDiagonalBatch = 64;
+    constexpr std::size_t AlphaPairBlock = 8;
+
+    // minimum number of tiles of pairs between two saves of the exact alpha
+    // matrix
+    constexpr std::size_t ExactRoundTiles = 4096;
+
+    // number of columns handled at once in the threshold mode
+    constexpr std::size_t ThresholdBatch = 8;
+
+    // number of paths generated with the same engine in the approx alpha
+    // matrix, and number of path vertices kept at once: the paths are
+    // accumulated in the matrix by rounds of chunks of this size
+    constexpr std::size_t ApproxChunkSize = 256;
+    constexpr std::size_t ApproxRoundVertices = std::size_t(1) << 23;
+
+    // number of columns of the approx alpha matrix merged at once with the
+    // paths of a round
+    constexpr std::size_t ApproxRoundColumns = 4096;
+
+    /*
+     * Path counts of maximum length of a graph crossing one vertex, taken
+     * from a batched computation where the count 0 is the number of paths and
+     * the count lane is the number of paths crossing the vertex.
+     */
+    struct CrossingPathCount {
+      const double *counts;
+      std::size_t count;
+      std::size_t batch;
+      std::size_t lane;
+      std::size_t length;
+
+      std::size_t getRows() const {
+        return 2 * count;
+      }
+
+      std::size_t getCols() const {
+        return length + 1;
+      }
+
+      double operator()(std::size_t row, std::size_t col) const {
+        if (row < count) {
+          return counts[(col * count + row) * batch + lane];
+        }
+
+        return counts[(col * count + row - count) * batch];
+      }
+    };
+
+    struct OwnedAdjacency {
+      std::vector<uint64_t> offsets;
+      std::vector<VertexDescriptor> targets;
+    };
+
+    struct MappedAdjacency {
+      void *data;
+      std::size_t size;
+
+      ~MappedAdjacency() {
+        munmap(data, size);
+      }
+    };
+
+    /*
+     * binary format
+     *
+     * header, final state bitmap (one word per 64 vertices), offsets (one
+     * word per vertex plus one), targets (one index of indexSize bytes per
+     * edge)
+     */
+
+    constexpr char BinaryMagic[8] = { 'D', 'I', 'S', 'C', 'G', 'R', 'P', 'H' };
+    constexpr uint32_t BinaryVersion = 1;
+
+    struct BinaryHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t indexSize;
+      uint64_t vertexCount;
+      uint64_t edgeCount;
+      uint64_t initialState;
+    };
+
+    static_assert(sizeof(BinaryHeader) % sizeof(uint64_t) == 0, "Arrays in the binary format must be aligned");
+    static_assert(sizeof(VertexDescriptor) == sizeof(Index), "Vertex descriptors are stored in place");
+
+    std::size_t getBinarySize(const BinaryHeader& header) {
+      return sizeof(BinaryHeader) + (Bitset::getWordCount(header.vertexCount) + header.vertexCount + 1) * sizeof(uint64_t) + header.edgeCount * header.indexSize;
+    }
+
+    // the offsets start at 0 and never decrease, and the targets are
+    // vertices, checked in parallel as the file may be large
+    template<typename T>
+    bool isBinaryAdjacencyValid(const uint64_t *offsets, const T *targets, std::size_t count, std::size_t edges) {
+      if (offsets[0] != 0) {
+        return false;
+      }
+
+      std::atomic<bool> valid(true);
+
+      parallelFor(count, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          if (offsets[i] > offsets[i + 1]) {
+            valid = false;
+            return;
+          }
+        }
+      });
+
+      parallelFor(edges, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; ++k) {
+          if (targets[k] >= count) {
+            valid = false;
+            return;
+          }
+        }
+      });
+
+      return valid;
+    }
+
+    // the largest vertex or edge count that fits in the index type
+    constexpr uint64_t MaximumCount = std::numeric_limits<Index>::max();
+
+    /*
+     * text format
+     */
+
+    struct TextScanner {
+      const char *current;
+      const char *end;
+      bool malformed;
+
+      // returns false at the end of the text or if the text is malformed
+      bool next(uint64_t& value) {
+        while (current != end && (*current == ' ' || *current == '\n' || *current == '\r' || *current == '\t')) {
+          ++current;
+        }
+
+        if (current == end) {
+          return false;
+        }
+
+        if (*current < '0' || *current > '9') {
+          malformed = true;
+          return false;
+        }
+
+        value = 0;
+
+        while (current != end && *current >= '0' && *current <= '9') {
+          uint64_t digit = *current - '0';
+
+          if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            malformed = true;
+            return false;
+          }
+
+          value = value * 10 + digit;
+          ++current;
+        }
+
+        return true;
+      }
+    };
+
+    struct TextChunk {
+      std::vector<Index> ends; // source and target of each edge
+      bool malformed;
+      uint64_t invalidVertex;
+    };
+
+  }
+
   Graph::Graph(std::size_t n)
-  : m_nextVertexId(0)
-  , m_nextEdgeId(0)
+  : m_vertexCount(0)
+  , m_finalized(false)
+  , m_offsets(nullptr)
+  , m_targets(nullptr)
+  , m_edgeCount(0)
   , m_initialState(InvalidVertexDescriptor)
   {
     if (n > 0) {
-      m_vertices.reserve(n);
-      m_outEdges.reserve(n);
+      m_finalStates.reserve(n);
     }
   }
 
   VertexDescriptor Graph::addVertex() {
-    auto id = m_nextVertexId++;
-    m_vertices.push_back({ id });
-    m_outEdges.push_back({ });
-    return id;
+    assert(!m_finalized);
+    assert(m_vertexCount < MaximumCount);
+    m_finalStates.resize(m_vertexCount + 1);
+    return { m_vertexCount++ };
   }
 
   Graph::VertexRange Graph::getVertices() const {
-    return makeIntegerRange<VertexDescriptor>({ 0 } , { m_vertices.size() });
+    return makeIntegerRange<VertexDescriptor>({ 0 } , { m_vertexCount });
   }
 
   std::size_t Graph::getVertexCount() const {
-    return m_vertices.size();
+    return m_vertexCount;
   }
 
   EdgeDescriptor Graph::addEdge(VertexDescriptor source, VertexDescriptor target) {
-    auto id = m_nextEdgeId++;
-    m_edges.push_back({ id, source, target });
-    m_outEdges[source.index].insert(id);
+    assert(!m_finalized);
+    assert(source.index < m_vertexCount);
+    assert(target.index < m_vertexCount);
+    assert(m_edges.size() < MaximumCount);
+    EdgeDescriptor id = { m_edges.size() };
+    m_edges.push_back({ source, target });
     return id;
   }
 
   Graph::EdgeRange Graph::getEdges() const {
-    return makeIntegerRange<EdgeDescriptor>({ 0 } , { m_edges.size() });
+    return makeIntegerRange<EdgeDescriptor>({ 0 } , { getEdgeCount() });
   }
 
   std::size_t Graph::getEdgeCount() const {
-    return m_edges.size();
+    return m_finalized ? m_edgeCount : m_edges.size();
   }
 
   VertexDescriptor Graph::getSource(EdgeDescriptor e) const {
-    return m_edges[e.index].source;
+    if (!m_finalized) {
+      return m_edges[e.index].source;
+    }
+
+    assert(e.index < m_edgeCount);
+    auto it = std::upper_bound(m_offsets, m_offsets + m_vertexCount + 1, e.index);
+    return { static_cast<std::size_t>(std::distance(m_offsets, it)) - 1 };
   }
 
   VertexDescriptor Graph::getTarget(EdgeDescriptor e) const {
-    return m_edges[e.index].target;
+    if (!m_finalized) {
+      return m_edges[e.index].target;
+    }
+
+    assert(e.index < m_edgeCount);
+    return m_targets[e.index];
+  }
+
+  void Graph::finalize() {
+    assert(!m_finalized);
+
+    auto adjacency = std::make_shared<OwnedAdjacency>();
+    auto& offsets = adjacency->offsets;
+    auto& targets = adjacency->targets;
+
+    // counting sort of the edges by source, stable so that the out edges of
+    // a vertex keep their insertion order
+
+    offsets.assign(m_vertexCount + 1, 0);
+
+    for (auto& edge : m_edges) {
+      ++offsets[edge.source.index + 1];
+    }
+
+    for (std::size_t i = 1; i < offsets.size(); ++i) {
+      offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+    targets.resize(m_edges.size());
+
+    for (auto& edge : m_edges) {
+      targets[next[edge.source.index]++] = edge.target;
+    }
+
+    m_offsets = offsets.data();
+    m_targets = targets.data();
+    m_edgeCount = targets.size();
+    m_adjacency = std::move(adjacency);
+
+    std::vector<Edge>().swap(m_edges);
+    m_finalized = true;
+  }
+
+  bool Graph::isFinalized() const {
+    return m_finalized;
   }
 
   Graph::OutEdgeRange Graph::getOutEdges(VertexDescriptor v) const {
-    return makeIteratorRange(m_outEdges[v.index]);
+    assert(m_finalized);
+    return makeIntegerRange<EdgeDescriptor>({ m_offsets[v.index] }, { m_offsets[v.index + 1] });
+  }
+
+  Graph::SuccessorRange Graph::getSuccessors(VertexDescriptor v) const {
+    assert(m_finalized);
+    return SuccessorRange(m_targets + m_offsets[v.index], m_targets + m_offsets[v.index + 1]);
+  }
+
+  std::size_t Graph::getOutDegree(VertexDescriptor v) const {
+    assert(m_finalized);
+    return m_offsets[v.index + 1] - m_offsets[v.index];
   }
 
   void Graph::setInitialState(VertexDescriptor v) {
@@ -93,15 +356,23 @@ namespace disc {
   }
 
   void Graph::addFinalState(VertexDescriptor v) {
-    m_finalStates.insert(v);
+    m_finalStates.set(v.index);
   }
 
   bool Graph::isFinalState(VertexDescriptor v) const {
-    return m_finalStates.count(v) > 0;
+    return m_finalStates.test(v.index);
   }
 
-  Graph::FinalStateRange Graph::getFinalStates() const {
-    return makeIteratorRange(m_finalStates);
+  std::vector<VertexDescriptor> Graph::getFinalStates() const {
+    std::vector<VertexDescriptor> res;
+
+    for (auto v : getVertices()) {
+      if (isFinalState(v)) {
+        res.push_back(v);
+      }
+    }
+
+    return res;
   }
 
   bool Graph::isConnected() const {
@@ -128,9 +399,7 @@ namespace disc {
       auto curr = todo.front();
       assert(visited[curr.index]);
 
-      for (auto e : getOutEdges(curr)) {
-        auto next = getTarget(e);
-
+      for (auto next : getSuccessors(curr)) {
         if (!visited[next.index]) {
           todo.push_back(next);
           visited[next.index] = true;
@@ -156,12 +425,14 @@ namespace disc {
     for (std::size_t k = 0; k < count; ++k) {
       bool update = false;
 
-      for (auto e : getEdges()) {
-        std::size_t newDistance = distance[getSource(e).index] + 1;
+      for (auto v : getVertices()) {
+        std::size_t newDistance = distance[v.index] + 1;
 
-        if (newDistance < distance[getTarget(e).index]) {
-          distance[getTarget(e).index] = newDistance;
-          update = true;
+        for (auto next : getSuccessors(v)) {
+          if (newDistance < distance[next.index]) {
+            distance[next.index] = newDistance;
+            update = true;
+          }
         }
       }
 
@@ -174,220 +445,481 @@ namespace disc {
   }
 
   Matrix<double> Graph::computePathCountOfExactLength(std::size_t length) const {
-    std::size_t count = getVertexCount();
+    return disc::computePathCountOfExactLength(*this, length);
+  }
 
-    Matrix<double> paths(count, length + 1);
-    paths.assign(0);
+  Matrix<double> Graph::computePathCountOfMaximumLength(std::size_t length) const {
+    return disc::computePathCountOfMaximumLength(*this, length);
+  }
 
-    for (auto v : getFinalStates()) {
-      paths(v.index, 0) = 1;
-    }
+  double Graph::countPathOfMaximumLengthFromInitialState(std::size_t length) const {
+    return disc::countPathOfMaximumLengthFromInitialState(*this, length);
+  }
 
-    for (std::size_t k = 1; k <= length; ++k) {
-      for (auto v : getVertices()) {
-        double pathCount = 0;
+  std::vector<VertexDescriptor> Graph::makeUniformPath(std::size_t length, Engine& engine, const Matrix<double>& paths) const {
+    return disc::makeUniformPath(*this, length, engine, paths);
+  }
 
-        for (auto e : getOutEdges(v)) {
-          pathCount += paths(getTarget(e).index, k - 1);
-        }
+  std::vector<VertexDescriptor> Graph::makeRandomPath(std::size_t length, Engine& engine) const {
+    std::vector<VertexDescriptor> path;
+    path.reserve(length + 1);
 
-        paths(v.index, k) = pathCount;
+    VertexDescriptor current = getInitialState();
+    path.push_back(current);
+
+    for (auto k = length; k > 0; --k) {
+      std::size_t degree = getOutDegree(current);
+
+      if (degree == 0) {
+        // no more candidates, we are at a final state
+        break;
       }
+
+      std::uniform_int_distribution<std::size_t> dist(0, degree - 1);
+      VertexDescriptor next = m_targets[m_offsets[current.index] + dist(engine)];
+
+      path.push_back(next);
+      current = next;
     }
 
-    return paths;
+    return path;
   }
 
-  Matrix<double> Graph::computePathCountOfMaximumLength(std::size_t length) const {
-    auto paths = computePathCountOfExactLength(length);
+  std::vector<VertexDescriptor> Graph::makeUnexploredPath(std::size_t length, Engine& engine, const CountedBitset& visited, std::size_t checkpoint, PathCountCache *cache) const {
+    VertexDescriptor unexplored;
 
-    for (std::size_t j = 1; j < paths.getCols(); ++j) {
-      for (std::size_t i = 0; i < paths.getRows(); ++i) {
-        paths(i, j) += paths(i, j - 1);
-      }
+    do {
+      std::uniform_int_distribution<std::size_t> dist(0, m_vertexCount - 1);
+      unexplored = { dist(engine) };
+    } while (visited.test(unexplored.index));
+
+    GraphCrossingOneVertex derived(*this, unexplored);
+    auto derivedPath = disc::makeCrossingUniformPath(derived, length, engine, checkpoint, cache);
+
+    std::vector<VertexDescriptor> path;
+
+    for (auto dv : derivedPath) {
+      VertexDescriptor v = derived(dv);
+      path.push_back(v);
+//       visited.insert(v);
     }
 
-    return paths;
-  }
+    assert(std::find(path.begin(), path.end(), unexplored) != path.end());
 
-  double Graph::countPathOfMaximumLengthFromInitialState(std::size_t length) const {
-    auto paths = computePathCountOfExactLength(length);
+    return path;
+  }
 
-    double count = 0;
+  std::vector<double> Graph::computeExactAlphaDiagonal(std::size_t length) const {
+    std::vector<VertexDescriptor> vertices;
+    vertices.reserve(m_vertexCount);
 
-    for (std::size_t j = 0; j < paths.getCols(); ++j) {
-      count += paths(m_initialState.index, j);
+    for (auto v : getVertices()) {
+      vertices.push_back(v);
     }
 
-    return count;
+    return computeExactAlphaDiagonal(length, vertices);
   }
 
-  std::vector<VertexDescriptor> Graph::makeUniformPath(std::size_t length, Engine& engine, const Matrix<double>& paths) const {
-    assert(paths.getRows() == getVertexCount());
-    assert(paths.getCols() == length + 1);
+  std::vector<double> Graph::computeExactAlphaDiagonal(std::size_t length, const std::vector<VertexDescriptor>& vertices) const {
+    // the paths crossing j are split at their last visit of j:
+    //   alpha_j = sum_t N_j(t) * G_j(length - t)
+    // where N_j(t) is the number of walks of length t from the initial state
+    // to j, computed for all the vertices at once, and G_j(r) is the number
+    // of paths of length at most r from j that do not come back to j,
+    // computed for a batch of vertices at once
 
-    std::vector<VertexDescriptor> path;
+    std::size_t count = getVertexCount();
+    std::size_t size = vertices.size();
 
-    VertexDescriptor current = getInitialState();
-    path.push_back(current);
+    static constexpr std::size_t NoLane = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> lanes(count, NoLane);
 
-    for (auto k = length; k > 0; --k) {
-      std::vector<VertexDescriptor> vertices;
-      std::vector<double> weights;
+    for (std::size_t l = 0; l < size; ++l) {
+      assert(lanes[vertices[l].index] == NoLane);
+      lanes[vertices[l].index] = l;
+    }
+
+    Matrix<double> walks(size, length + 1);
+
+    {
+      std::vector<double> prev(count, 0.0);
+      std::vector<double> curr(count);
+      prev[getInitialState().index] = 1;
 
-      for (auto e : getOutEdges(current)) {
-        assert(getSource(e) == current);
-        VertexDescriptor next = getTarget(e);
+      for (std::size_t t = 0; t <= length; ++t) {
+        if (t > 0) {
+          std::fill(curr.begin(), curr.end(), 0.0);
 
-        double weight = paths(next.index, k - 1);
+          for (auto u : getVertices()) {
+            double walkCount = prev[u.index];
 
-        if (weight > 0) {
-          vertices.push_back(next);
-          weights.push_back(weight);
+            if (walkCount == 0) {
+              continue;
+            }
+
+            for (auto next : getSuccessors(u)) {
+              curr[next.index] += walkCount;
+            }
+          }
+
+          prev.swap(curr);
+        }
+
+        for (std::size_t l = 0; l < size; ++l) {
+          walks(l, t) = prev[vertices[l].index];
         }
       }
+    }
 
-      if (vertices.empty()) {
-        // no more candidates, we are at a final state
-        break;
+    // the batches are computed in parallel, each thread with its own buffers
+
+    struct Scratch {
+      std::vector<double> counts;
+      Matrix<double> leaving;
+    };
+
+    std::vector<double> res(size, 0.0);
+    std::vector<Scratch> scratches(getThreadCount());
+
+    parallelSteal((size + AlphaDiagonalBatch - 1) / AlphaDiagonalBatch, [&](std::size_t index, std::size_t thread) {
+      std::size_t first = index * AlphaDiagonalBatch;
+      std::size_t batch = std::min(AlphaDiagonalBatch, size - first);
+      auto& counts = scratches[thread].counts;
+      auto& leaving = scratches[thread].leaving;
+
+      if (leaving.isEmpty()) {
+        leaving.resize(AlphaDiagonalBatch, length + 1);
       }
 
-      double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+      disc::computeBatchedPathCountOfExactLength(*this, length, batch, 2, counts, [&](VertexDescriptor v, std::size_t k, double *c) {
+        if (k == 0) {
+          std::fill(c, c + batch, isFinalState(v) ? 1.0 : 0.0);
+        }
+
+        std::size_t lane = lanes[v.index];
 
-      if (sum <= std::numeric_limits<double>::epsilon()) {
-        std::fill(weights.begin(), weights.end(), 1.0);
+        if (lane != NoLane && first <= lane && lane < first + batch) {
+          leaving(lane - first, k) = c[lane - first];
+          c[lane - first] = 0;
+        }
+      });
+
+      for (std::size_t l = 0; l < batch; ++l) {
+        for (std::size_t r = 1; r <= length; ++r) {
+          leaving(l, r) += leaving(l, r - 1);
+        }
+
+        double alpha = 0;
+
+        for (std::size_t t = 0; t <= length; ++t) {
+          alpha += walks(first + l, t) * leaving(l, length - t);
+        }
+
+        res[first + l] = alpha;
       }
+    });
+
+    return res;
+  }
 
-      std::discrete_distribution<> dist(weights.begin(), weights.end());
-      VertexDescriptor next = vertices[dist(engine)];
+  // builds a symmetric matrix from its lower triangle, diagonal included
+  static SparseMatrix<double> matrixExpandLowerTriangle(const SparseMatrix<double>& lower) {
+    assert(lower.getRows() == lower.getCols());
+    std::size_t size = lower.getCols();
+    std::vector<std::size_t> offsets(size + 1, 0);
 
-      path.push_back(next);
-      current = next;
+    for (std::size_t j = 0; j < size; ++j) {
+      for (std::size_t k = lower.getColumnBegin(j); k < lower.getColumnEnd(j); ++k) {
+        std::size_t i = lower.getRow(k);
+        ++offsets[j + 1];
+
+        if (i != j) {
+          ++offsets[i + 1];
+        }
+      }
     }
 
-    assert(isFinalState(current));
-    // assert(path.size() == length);
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
 
-    return path;
-  }
+    // the columns are visited in order, so the entries of a column coming
+    // from the upper triangle are added by increasing row, before the entries
+    // of its own lower triangle
 
-  std::vector<VertexDescriptor> Graph::makeRandomPath(std::size_t length, Engine& engine) const {
-    std::vector<VertexDescriptor> path;
+    std::vector<SparseMatrix<double>::RowIndex> indices(offsets.back());
+    std::vector<double> values(offsets.back());
+    std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
 
-    VertexDescriptor current = getInitialState();
-    path.push_back(current);
+    for (std::size_t j = 0; j < size; ++j) {
+      for (std::size_t k = lower.getColumnBegin(j); k < lower.getColumnEnd(j); ++k) {
+        std::size_t i = lower.getRow(k);
+        double value = lower.getValue(k);
 
-    for (auto k = length; k > 0; --k) {
-      std::vector<VertexDescriptor> vertices;
+        indices[next[j]] = i;
+        values[next[j]++] = value;
 
-      for (auto e : getOutEdges(current)) {
-        assert(getSource(e) == current);
-        VertexDescriptor next = getTarget(e);
-        vertices.push_back(next);
+        if (i != j) {
+          indices[next[i]] = j;
+          values[next[i]++] = value;
+        }
       }
+    }
 
-      if (vertices.empty()) {
-        // no more candidates, we are at a final state
-        break;
-      }
+    return SparseMatrix<double>(size, std::move(offsets), std::move(indices), std::move(values));
+  }
 
-      std::uniform_int_distribution<std::size_t> dist(0, vertices.size() - 1);
-      VertexDescriptor next = vertices[dist(engine)];
+  // identifies a computation on this graph in a snapshot
+  static std::string makeSnapshotSignature(const Graph& g, const std::string& computation) {
+    uint64_t hash = UINT64_C(14695981039346656037);
 
-      path.push_back(next);
-      current = next;
+    auto mix = [&hash](uint64_t value) {
+      hash ^= value;
+      hash *= UINT64_C(1099511628211);
+    };
+
+    mix(g.getVertexCount());
+    mix(g.getEdgeCount());
+    mix(g.getInitialState().index);
+
+    for (auto v : g.getVertices()) {
+      mix(g.isFinalState(v) ? 1 : 0);
+
+      for (auto next : g.getSuccessors(v)) {
+        mix(next.index);
+      }
     }
 
-    return path;
+    std::ostringstream signature;
+    signature << computation << " graph " << std::hex << hash;
+    return signature.str();
   }
 
-  std::vector<VertexDescriptor> Graph::makeUnexploredPath(std::size_t length, Engine& engine, std::set<VertexDescriptor>& visited) const {
-    VertexDescriptor unexplored;
+  SparseMatrix<double> Graph::computeExactAlphaMatrix(std::size_t length, AlphaSnapshot *snapshot) const {
+    std::size_t count = getVertexCount();
+    std::size_t init = getInitialState().index;
 
-    do {
-      std::uniform_int_distribution<std::size_t> dist(0, m_vertices.size() - 1);
-      unexplored = m_vertices[dist(engine)].id;
-    } while (visited.find(unexplored) != visited.end());
+    // the columns of the lower triangle that are done are saved in the
+    // snapshot
 
-    auto derived = buildGraphCrossingOneVertex(*this, unexplored);
-    auto paths = derived.computePathCountOfMaximumLength(length);
-    auto derivedPath = derived.makeUniformPath(length, engine, paths);
+    std::string signature = makeSnapshotSignature(*this, "exact length " + std::to_string(length));
+    AlphaState state;
 
-    std::vector<VertexDescriptor> path;
+    if (snapshot != nullptr && snapshot->load(signature, state) && state.parts.size() == 1) {
+      std::cout << "resuming at column " << state.parts[0].getCols() << '/' << count << '\n';
+    } else {
+      state.parts.assign(1, SparseMatrix<double>(count));
+    }
 
-    for (auto dv : derivedPath) {
-      VertexDescriptor v = derived(dv);
-      path.push_back(v);
-//       visited.insert(v);
+    auto& lower = state.parts[0];
+
+    if (lower.getCols() == count) {
+      return matrixExpandLowerTriangle(lower);
     }
 
-    assert(std::find(path.begin(), path.end(), unexplored) != path.end());
+    // alpha_j
 
-    return path;
-  }
+    auto diagonal = computeExactAlphaDiagonal(length);
 
-  Matrix<double> Graph::computeExactAlphaMatrix(std::size_t length) const {
-    std::size_t count = getVertexCount();
+    // alpha_i_j, computed for a tile of pairs at once: the count 0 is the
+    // number of paths, then the number of paths crossing each vertex of the
+    // blocks, then the number of paths crossing both vertices of each pair
+    // (the paths from i crossing j are counted at i and vice versa). Only the
+    // lower triangle is built, the matrix is symmetric. The tiles are handed
+    // out with work stealing as their number of pairs varies (no pair is
+    // computed for a vertex that no path crosses)
+
+    struct Pin {
+      std::size_t lane;
+      std::size_t source;
+    };
+
+    struct Pair {
+      std::size_t i;
+      std::size_t j;
+      std::size_t lane;
+      double sum;
+    };
 
-    Matrix<double> m(count, count);
+    struct Scratch {
+      std::vector<double> counts;
+      std::vector<Pair> pairs;
+      std::vector<std::vector<Pin>> pins;
+    };
 
-    for (auto j : getVertices()) {
-      std::cout << '\r' << j.index + 1 << '/' << count << std::flush;
+    // the tiles (j0, i0) with i0 >= j0 are numbered block of columns by
+    // block of columns
 
-      // alpha_j
+    std::size_t blocks = (count + AlphaPairBlock - 1) / AlphaPairBlock;
+    std::vector<std::size_t> firstTiles(blocks + 1, 0);
 
-      {
-        auto derived = buildGraphCrossingOneVertex(*this, j);
-        m(j.index, j.index) = derived.countPathOfMaximumLengthFromInitialState(length);
+    for (std::size_t b = 0; b < blocks; ++b) {
+      firstTiles[b + 1] = firstTiles[b] + blocks - b;
+    }
+
+    std::vector<Scratch> scratches(getThreadCount());
+    Progress progress(firstTiles.back());
+
+    assert(lower.getCols() % AlphaPairBlock == 0);
+    std::size_t firstBlock = lower.getCols() / AlphaPairBlock;
+
+    if (firstBlock > 0) {
+      progress.add(firstTiles[firstBlock]);
+    }
+
+    // the blocks of columns are done by rounds of at least ExactRoundTiles
+    // tiles, the state is saved between two rounds
+
+    for (std::size_t b0 = firstBlock; b0 < blocks; ) {
+      std::size_t b1 = b0 + 1;
+
+      while (b1 < blocks && firstTiles[b1] - firstTiles[b0] < ExactRoundTiles) {
+        ++b1;
       }
 
-      // alpha_i_j
+      std::size_t columnBegin = b0 * AlphaPairBlock;
+      std::size_t columnEnd = std::min(b1 * AlphaPairBlock, count);
+
+      std::vector<std::vector<std::pair<Index, double>>> columns(columnEnd - columnBegin);
+      std::vector<std::mutex> locks(b1 - b0);
+
+      parallelSteal(firstTiles[b1] - firstTiles[b0], [&](std::size_t index, std::size_t thread) {
+        std::size_t tile = firstTiles[b0] + index;
+        std::size_t b = std::upper_bound(firstTiles.begin(), firstTiles.end(), tile) - firstTiles.begin() - 1;
+        std::size_t j0 = b * AlphaPairBlock;
+        std::size_t i0 = (b + tile - firstTiles[b]) * AlphaPairBlock;
+        std::size_t jsize = std::min(AlphaPairBlock, count - j0);
+        std::size_t isize = std::min(AlphaPairBlock, count - i0);
+        std::size_t ilane = i0 == j0 ? 1 : 1 + jsize;
+
+        auto& pairs = scratches[thread].pairs;
+        auto& pins = scratches[thread].pins;
+
+        auto getLane = [&](std::size_t v) {
+          return v < j0 + jsize ? 1 + v - j0 : ilane + v - i0;
+        };
+
+        std::size_t lanes = ilane + isize;
+        pairs.clear();
+        pins.resize(lanes - 1);
+
+        for (auto& pin : pins) {
+          pin.clear();
+        }
+
+        for (std::size_t j = j0; j < j0 + jsize; ++j) {
+          if (diagonal[j] <= 0) {
+            continue;
+          }
+
+          for (std::size_t i = std::max(i0, j + 1); i < i0 + isize; ++i) {
+            if (diagonal[i] <= 0) {
+              continue;
+            }
+
+            pairs.push_back({ i, j, lanes, 0.0 });
+            pins[getLane(i) - 1].push_back({ lanes, getLane(j) });
+            pins[getLane(j) - 1].push_back({ lanes, getLane(i) });
+            ++lanes;
+          }
+        }
+
+        if (!pairs.empty()) {
+          disc::computeBatchedPathCountOfExactLength(*this, length, lanes, 2, scratches[thread].counts, [&](VertexDescriptor v, std::size_t k, double *c) {
+            if (k == 0) {
+              c[0] = isFinalState(v) ? 1 : 0;
+            }
+
+            if ((j0 <= v.index && v.index < j0 + jsize) || (i0 <= v.index && v.index < i0 + isize)) {
+              std::size_t lane = getLane(v.index);
+              c[lane] = c[0];
+
+              for (auto& pin : pins[lane - 1]) {
+                c[pin.lane] = c[pin.source];
+              }
+            }
+
+            if (v.index == init) {
+              for (auto& pair : pairs) {
+                pair.sum += c[pair.lane];
+              }
+            }
+          });
+
+          std::lock_guard<std::mutex> lock(locks[b - b0]);
+
+          for (auto& pair : pairs) {
+            if (pair.sum > 0) {
+              columns[pair.j - columnBegin].push_back({ pair.i, pair.sum });
+            }
+          }
+        }
+
+        progress.add();
+      });
+
+      // the tiles of a column are done in any order
+
+      for (std::size_t j = columnBegin; j < columnEnd; ++j) {
+        auto& column = columns[j - columnBegin];
+        std::sort(column.begin(), column.end());
+
+        lower.addColumn();
+
+        if (diagonal[j] > 0) {
+          lower.addEntry(j, diagonal[j]);
+        }
 
-      for (auto i = j.next(); i.index < count; ++i) {
-        if (m(j.index, j.index) > 0) {
-          auto derived = buildGraphCrossingTwoVertices(*this, i, j);
-          m(i.index, j.index) = m(j.index, i.index) = derived.countPathOfMaximumLengthFromInitialState(length);
-        } else {
-          m(i.index, j.index) = m(j.index, i.index) = 0;
+        for (auto& entry : column) {
+          lower.addEntry(entry.first, entry.second);
         }
       }
+
+      b0 = b1;
+
+      if (snapshot != nullptr && snapshot->isDue()) {
+        snapshot->save(signature, state);
+      }
     }
 
-    std::cout << '\n';
-    return m;
+    progress.finish();
+
+    if (snapshot != nullptr) {
+      snapshot->save(signature, state);
+    }
+
+    return matrixExpandLowerTriangle(lower);
   }
 
-  static void matrixNormalizeByDiagonal(Matrix<double>& m) {
+  static SparseMatrix<double> matrixNormalizeByDiagonal(const SparseMatrix<double>& m) {
     assert(m.getRows() == m.getCols());
     std::size_t size = m.getRows();
     int zeroes = 0;
 
-    for (std::size_t j = 0; j < size; ++j) {
-      if (m(j, j) <= std::numeric_limits<double>::epsilon()) {
-        ++zeroes;
+    SparseMatrix<double> res(size);
+    res.reserve(m.getNonZeroCount() + size);
 
-        for (std::size_t i = 0; i < size; ++i) {
-          m(i, j) = 0;
-        }
+    for (std::size_t j = 0; j < size; ++j) {
+      res.addColumn();
+      double alphaJ = m(j, j);
 
-        m(j, j) = 1;
+      if (alphaJ <= std::numeric_limits<double>::epsilon()) {
+        ++zeroes;
+        res.addEntry(j, 1);
       } else {
-        double alphaJ = m(j, j);
-
-        for (std::size_t i = 0; i < size; ++i) {
-          m(i, j) /= alphaJ;
+        for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+          res.addEntry(m.getRow(k), m.getValue(k) / alphaJ);
         }
       }
     }
 
     std::cout << "number of zeroes on the diagonal: " << zeroes << '/' << size <<  '\n';
+
+    return res;
   }
 
-  Matrix<double> Graph::computeExactNormalizedAlphaMatrix(std::size_t length) const {
+  SparseMatrix<double> Graph::computeExactNormalizedAlphaMatrix(std::size_t length, AlphaSnapshot *snapshot) const {
     auto start = std::chrono::steady_clock::now();
 
-    auto m = computeExactAlphaMatrix(length);
-    matrixNormalizeByDiagonal(m);
+    auto m = matrixNormalizeByDiagonal(computeExactAlphaMatrix(length, snapshot));
 
     auto finish = std::chrono::steady_clock::now();
 
@@ -397,41 +929,292 @@ namespace disc {
     return m;
   }
 
-  Matrix<double> Graph::computeApproxAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine) const {
-    auto paths = computePathCountOfMaximumLength(length);
-    std::size_t count = getVertexCount();
+  static std::string makeApproxComputation(const char *kind, std::size_t length, std::size_t tries, CoOccurrence occurrence) {
+    std::ostringstream computation;
+    computation << kind << " length " << length << " tries " << tries << " occurrence " << (occurrence == CoOccurrence::Distinct ? "distinct" : "multiplicity");
+    return computation.str();
+  }
+
+  // resumes the state of an approximated alpha matrix, or starts a new state
+  // with the seed of the paths
+  static void startApproxState(const Graph& g, AlphaSnapshot *snapshot, const std::string& signature, Engine& engine, AlphaState& state) {
+    if (snapshot != nullptr && snapshot->load(signature, state) && !state.parts.empty()) {
+      if (state.parts.size() == 1) {
+        std::cout << "resuming at path chunk " << state.progress << '\n';
+      } else {
+        std::cout << "resuming at column " << state.parts.back().getCols() << '/' << g.getVertexCount() << '\n';
+      }
+
+      engine = state.engine;
+      return;
+    }
+
+    state.seed = (static_cast<uint64_t>(engine()) << 32) | engine();
+    state.progress = 0;
+    state.engine = engine;
+
+    // the approximated alpha matrix starts with all its columns, empty
+    SparseMatrix<double> m(g.getVertexCount());
+
+    for (std::size_t j = 0; j < g.getVertexCount(); ++j) {
+      m.addColumn();
+    }
+
+    state.parts.assign(1, std::move(m));
+  }
+
+  // appends the columns of a block of a matrix
+  static void matrixAppendColumns(SparseMatrix<double>& m, const SparseMatrix<double>& block) {
+    for (std::size_t j = 0; j < block.getCols(); ++j) {
+      m.addColumn();
+
+      for (std::size_t k = block.getColumnBegin(j); k < block.getColumnEnd(j); ++k) {
+        m.addEntry(block.getRow(k), block.getValue(k));
+      }
+    }
+  }
+
+  // adds the missing paths to the approximated alpha matrix, progress is the
+  // number of chunks of paths that are already in the matrix. When the
+  // snapshot is due after a round of chunks, the matrix is put together and
+  // save() is called.
+  template<typename Func>
+  static void accumulateApproxAlphaMatrix(const Graph& g, std::size_t length, std::size_t tries, uint64_t seed, CoOccurrence occurrence, SparseMatrix<double>& m, uint64_t& progress, AlphaSnapshot *snapshot, Func save) {
+    std::size_t count = g.getVertexCount();
+    std::size_t chunks = (tries + ApproxChunkSize - 1) / ApproxChunkSize;
+    assert(m.getCols() == count);
+
+    if (progress >= chunks) {
+      return;
+    }
+
+    auto paths = g.computePathCountOfMaximumLength(length);
+
+    // the paths are generated by chunks, each chunk with its own engine, so
+    // that the result depends on the seed but not on the number of threads.
+    // Only the paths of a round of chunks are kept, sorted, then each column
+    // of the matrix is merged with the paths of the round crossing its
+    // vertex. The counts are integers, so the result does not depend on the
+    // rounds either.
+
+    std::size_t roundChunks = std::max(ApproxRoundVertices / (ApproxChunkSize * (length + 1)), std::size_t(1));
+
+    // the matrix is kept by blocks of columns while the paths are added, so
+    // that merging a block with a round only copies this block
+
+    std::vector<SparseMatrix<double>> blocks;
+
+    for (std::size_t columnBegin = 0; columnBegin < count; columnBegin += ApproxRoundColumns) {
+      std::size_t columnEnd = std::min(columnBegin + ApproxRoundColumns, count);
+      SparseMatrix<double> block(count);
+      block.reserve(m.getColumnEnd(columnEnd - 1) - m.getColumnBegin(columnBegin));
+
+      for (std::size_t j = columnBegin; j < columnEnd; ++j) {
+        block.addColumn();
+
+        for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+          block.addEntry(m.getRow(k), m.getValue(k));
+        }
+      }
+
+      blocks.push_back(std::move(block));
+    }
+
+    SparseMatrix<double>(count).swap(m);
+
+    std::vector<std::vector<VertexDescriptor>> samples;
+    std::vector<std::size_t> offsets;
+    std::vector<uint32_t> crossing;
+    std::vector<std::size_t> next;
+
+    // each column is accumulated in a dense vector of the thread, only the
+    // rows that are touched are kept
+
+    struct Scratch {
+      std::vector<double> column;
+      std::vector<Index> rows;
+    };
+
+    std::vector<Scratch> scratches(getThreadCount());
+
+    for (std::size_t first = progress; first < chunks; first += roundChunks) {
+      std::size_t last = std::min(first + roundChunks, chunks);
+      std::size_t begin = first * ApproxChunkSize;
+      std::size_t end = std::min(last * ApproxChunkSize, tries);
+      assert(end - begin <= std::numeric_limits<uint32_t>::max());
+
+      samples.resize(end - begin);
+
+      parallelForEach(last - first, [&](std::size_t i) {
+        std::size_t chunk = first + i;
+        Engine chunkEngine = getStreamEngine(seed, chunk);
+        PathSampler<Graph> sampler(g, length, paths);
+
+        for (std::size_t k = chunk * ApproxChunkSize; k < std::min((chunk + 1) * ApproxChunkSize, tries); ++k) {
+          auto& path = samples[k - begin];
+          sampler.sample(chunkEngine, path);
+          std::sort(path.begin(), path.end());
+
+          if (occurrence == CoOccurrence::Distinct) {
+            path.erase(std::unique(path.begin(), path.end()), path.end());
+          }
+        }
+      });
 
-    Matrix<double> m(count, count);
+      // the paths of the round crossing each vertex, listed once even when
+      // the vertex occurs several times in the path
 
-    for (std::size_t i = 0; i < tries; ++i) {
-      std::cout << '\r' << i + 1 << '/' << tries << std::flush;
+      offsets.assign(count + 1, 0);
 
-      auto path = makeUniformPath(length, engine, paths);
+      for (auto& path : samples) {
+        for (auto it = path.begin(); it != path.end(); it = std::upper_bound(it, path.end(), *it)) {
+          ++offsets[it->index + 1];
+        }
+      }
+
+      std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+      crossing.resize(offsets.back());
+      next.assign(offsets.begin(), offsets.end() - 1);
 
-      for (auto v : path) {
-        ++m(v.index, v.index);
+      for (std::size_t k = 0; k < samples.size(); ++k) {
+        auto& path = samples[k];
+
+        for (auto it = path.begin(); it != path.end(); it = std::upper_bound(it, path.end(), *it)) {
+          crossing[next[it->index]++] = static_cast<uint32_t>(k);
+        }
       }
 
-      for (auto u : path) {
-        for (auto v : path) {
-          if (u != v) {
-            ++m(u.index, v.index);
+      // each block is merged with the paths of the round
+
+      for (std::size_t b = 0; b < blocks.size(); ++b) {
+        auto& block = blocks[b];
+        std::size_t columnBegin = b * ApproxRoundColumns;
+        std::size_t columnEnd = columnBegin + block.getCols();
+        std::vector<std::vector<std::pair<Index, double>>> columns(columnEnd - columnBegin);
+
+        parallelSteal(columnEnd - columnBegin, [&](std::size_t index, std::size_t thread) {
+          std::size_t j = columnBegin + index;
+          auto& column = scratches[thread].column;
+          auto& rows = scratches[thread].rows;
+
+          column.resize(count, 0.0);
+          rows.clear();
+
+          for (std::size_t k = block.getColumnBegin(index); k < block.getColumnEnd(index); ++k) {
+            rows.push_back(static_cast<Index>(block.getRow(k)));
+            column[block.getRow(k)] = block.getValue(k);
+          }
+
+          for (std::size_t l = offsets[j]; l < offsets[j + 1]; ++l) {
+            auto& path = samples[crossing[l]];
+
+            if (occurrence == CoOccurrence::Distinct) {
+              for (auto u : path) {
+                if (column[u.index] == 0) {
+                  rows.push_back(u.index);
+                }
+
+                column[u.index] += 1;
+              }
+
+              continue;
+            }
+
+            // every occurrence of u is counted with every occurrence of j,
+            // and every occurrence of j once on the diagonal
+
+            auto run = std::equal_range(path.begin(), path.end(), VertexDescriptor(j));
+            double occurrencesJ = static_cast<double>(run.second - run.first);
+
+            for (auto it = path.begin(); it != path.end(); ) {
+              auto runEnd = std::upper_bound(it, path.end(), *it);
+              double occurrencesU = static_cast<double>(runEnd - it);
+
+              if (column[it->index] == 0) {
+                rows.push_back(it->index);
+              }
+
+              column[it->index] += it->index == j ? occurrencesJ : occurrencesU * occurrencesJ;
+              it = runEnd;
+            }
+          }
+
+          std::sort(rows.begin(), rows.end());
+          auto& entries = columns[index];
+          entries.reserve(rows.size());
+
+          for (auto i : rows) {
+            entries.push_back({ i, column[i] });
+            column[i] = 0;
+          }
+        });
+
+        SparseMatrix<double> merged(count);
+        std::size_t entryCount = 0;
+
+        for (auto& entries : columns) {
+          entryCount += entries.size();
+        }
+
+        merged.reserve(entryCount);
+
+        for (auto& entries : columns) {
+          merged.addColumn();
+
+          for (auto& entry : entries) {
+            merged.addEntry(entry.first, entry.second);
           }
+
+          std::vector<std::pair<Index, double>>().swap(entries);
         }
+
+        block.swap(merged);
       }
 
+      progress = last;
+      std::cout << '\r' << end << '/' << tries << std::flush;
+
+      if (snapshot != nullptr && snapshot->isDue()) {
+        for (auto& block : blocks) {
+          matrixAppendColumns(m, block);
+        }
+
+        save();
+        SparseMatrix<double>(count).swap(m);
+      }
     }
 
     std::cout << '\n';
 
-    return m;
+    // the blocks are released as soon as they are in the matrix
+
+    for (auto& block : blocks) {
+      matrixAppendColumns(m, block);
+      SparseMatrix<double>().swap(block);
+    }
+  }
+
+  SparseMatrix<double> Graph::computeApproxAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine, CoOccurrence occurrence, AlphaSnapshot *snapshot) const {
+    std::string signature = makeSnapshotSignature(*this, makeApproxComputation("approx", length, tries, occurrence));
+    AlphaState state;
+    startApproxState(*this, snapshot, signature, engine, state);
+
+    accumulateApproxAlphaMatrix(*this, length, tries, state.seed, occurrence, state.parts[0], state.progress, snapshot, [&]() {
+      snapshot->save(signature, state);
+    });
+
+    if (snapshot != nullptr) {
+      snapshot->save(signature, state);
+    }
+
+    return std::move(state.parts[0]);
   }
 
-  Matrix<double> Graph::computeApproxNormalizedAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine) const {
+  SparseMatrix<double> Graph::computeApproxNormalizedAlphaMatrix(std::size_t length, std::size_t tries, Engine& engine, CoOccurrence occurrence, AlphaSnapshot *snapshot) const {
     auto start = std::chrono::steady_clock::now();
 
-    auto m = computeApproxAlphaMatrix(length, tries, engine);
-    matrixNormalizeByDiagonal(m);
+    auto m = matrixNormalizeByDiagonal(computeApproxAlphaMatrix(length, tries, engine, occurrence, snapshot));
 
     auto finish = std::chrono::steady_clock::now();
 
@@ -441,55 +1224,181 @@ namespace disc {
     return m;
   }
 
-  Matrix<double> Graph::computeApproxNormalizedAlphaMatrixWithThreshold(std::size_t length, std::size_t tries, Engine& engine, double threshold) const {
+  SparseMatrix<double> Graph::computeApproxNormalizedAlphaMatrixWithThreshold(std::size_t length, std::size_t tries, Engine& engine, double threshold, CoOccurrence occurrence, AlphaSnapshot *snapshot) const {
     auto start = std::chrono::steady_clock::now();
 
-    auto m = computeApproxAlphaMatrix(length, tries, engine);
+    // the first part of the state is the approximated alpha matrix, the
+    // second part is the columns of the result that are done
 
-    // special treatment when m(j, j) == 0
+    std::ostringstream computation;
+    computation << makeApproxComputation("threshold", length, tries, occurrence) << " threshold " << threshold;
+    std::string signature = makeSnapshotSignature(*this, computation.str());
+    AlphaState state;
+    startApproxState(*this, snapshot, signature, engine, state);
+
+    accumulateApproxAlphaMatrix(*this, length, tries, state.seed, occurrence, state.parts[0], state.progress, snapshot, [&]() {
+      snapshot->save(signature, state);
+    });
+
+    std::size_t size = getVertexCount();
+
+    if (state.parts.size() == 1) {
+      state.parts.emplace_back(size);
+    }
+
+    auto& m = state.parts[0];
+    auto& res = state.parts[1];
+
+    // special treatment when m(j, j) <= threshold: the column is replaced
 
     int zeroes = 0;
-    std::size_t size = m.getRows();
     std::size_t r = static_cast<std::size_t>(threshold);
 
+    std::vector<VertexDescriptor> columns;
+
     for (std::size_t j = 0; j < size; ++j) {
       if (m(j, j) <= threshold) {
         ++zeroes;
 
-        for (std::size_t i = 0; i < size; ++i) {
-          m(i, j) = 0;
+        if (j >= res.getCols()) {
+          columns.push_back({ j });
+        }
+      }
+    }
+
+    std::vector<bool> replaced(size, false);
+    std::vector<std::vector<std::pair<Index, double>>> replacements(size);
+
+    // no path crosses j when alpha_j == 0, the column is treated as in
+    // matrixNormalizeByDiagonal
+
+    {
+      auto alpha = computeExactAlphaDiagonal(length, columns);
+      std::size_t kept = 0;
+
+      for (std::size_t l = 0; l < columns.size(); ++l) {
+        std::size_t j = columns[l].index;
+        replaced[j] = true;
+
+        if (alpha[l] > 0) {
+          columns[kept++] = columns[l];
+          continue;
+        }
+
+        replacements[j].push_back({ j, 1.0 });
+      }
+
+      columns.resize(kept);
+    }
+
+    // adds the columns of the result up to end
+
+    auto addColumns = [&](std::size_t end) {
+      for (std::size_t j = res.getCols(); j < end; ++j) {
+        res.addColumn();
+
+        if (replaced[j]) {
+          for (auto& entry : replacements[j]) {
+            res.addEntry(entry.first, entry.second);
+          }
+
+          std::vector<std::pair<Index, double>>().swap(replacements[j]);
+          continue;
+        }
+
+        double alphaJ = m(j, j);
+
+        for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+          res.addEntry(m.getRow(k), m.getValue(k) / alphaJ);
         }
+      }
+    };
+
+    // the paths crossing j are generated for a block of columns at once: the
+    // count 0 is the number of paths and the count 1 + l is the number of
+    // paths crossing the l-th column of the block
+
+    std::vector<double> counts;
+    std::vector<VertexDescriptor> path;
+    std::vector<double> column(size, 0.0);
+    std::vector<Index> rows;
+    CountedBitset crossed(size);
+    std::vector<Index> distinct;
+
+    for (std::size_t first = 0; first < columns.size(); first += ThresholdBatch) {
+      std::size_t batch = std::min(ThresholdBatch, columns.size() - first);
+      const VertexDescriptor *block = columns.data() + first;
+
+      disc::computeBatchedPathCountOfMaximumLength(*this, length, batch + 1, counts, [&](VertexDescriptor v, std::size_t k, double *c) {
+        if (k == 0) {
+          c[0] = isFinalState(v) ? 1 : 0;
+        }
+
+        for (std::size_t l = 0; l < batch; ++l) {
+          if (block[l] == v) {
+            c[1 + l] = c[0];
+          }
+        }
+      });
 
-        auto derived = buildGraphCrossingOneVertex(*this, { j });
-        auto paths = derived.computePathCountOfMaximumLength(length);
+      for (std::size_t l = 0; l < batch; ++l) {
+        std::size_t j = block[l].index;
+
+        GraphCrossingOneVertex derived(*this, { j });
+        CrossingPathCount paths = { counts.data(), size, batch + 1, 1 + l, length };
+        PathSampler<GraphCrossingOneVertex, CrossingPathCount> sampler(derived, length, paths);
+
+        rows.clear();
 
         for (std::size_t k = 0; k < r; ++k) {
-          auto path = derived.makeUniformPath(length, engine, paths);
+          sampler.sample(engine, path);
 
-          std::set<VertexDescriptor> set;
+          distinct.clear();
 
           for (auto v : path) {
-            set.insert(derived(v).index);
+            Index i = derived(v).index;
+
+            if (crossed.insert(i)) {
+              distinct.push_back(i);
+            }
           }
 
-          for (auto v : set) {
-            ++m(v.index, j);
+          for (auto i : distinct) {
+            if (column[i] == 0) {
+              rows.push_back(i);
+            }
+
+            ++column[i];
+            crossed.erase(i);
           }
         }
 
-        double alphaJ = m(j, j);
+        double alphaJ = column[j];
         assert(static_cast<std::size_t>(alphaJ) == r);
 
-        for (std::size_t i = 0; i < size; ++i) {
-          m(i, j) /= alphaJ;
-        }
-      } else {
-        double alphaJ = m(j, j);
+        std::sort(rows.begin(), rows.end());
 
-        for (std::size_t i = 0; i < size; ++i) {
-          m(i, j) /= alphaJ;
+        for (auto i : rows) {
+          replacements[j].push_back({ i, column[i] / alphaJ });
+          column[i] = 0;
         }
       }
+
+      // the engine is saved with the columns it has generated
+
+      addColumns(block[batch - 1].index + 1);
+
+      if (snapshot != nullptr && snapshot->isDue()) {
+        state.engine = engine;
+        snapshot->save(signature, state);
+      }
+    }
+
+    addColumns(size);
+
+    if (snapshot != nullptr) {
+      state.engine = engine;
+      snapshot->save(signature, state);
     }
 
     auto finish = std::chrono::steady_clock::now();
@@ -500,15 +1409,17 @@ namespace disc {
     std::cout << "alpha_ij_over_alpha_j construction: " << diff.count() << '\n';
 
 
-    return m;
+    return std::move(res);
   }
 
   void Graph::clear() {
-    m_nextVertexId = 0;
-    m_nextEdgeId = 0;
-    m_vertices.clear();
+    m_vertexCount = 0;
+    m_finalized = false;
     m_edges.clear();
-    m_outEdges.clear();
+    m_adjacency.reset();
+    m_offsets = nullptr;
+    m_targets = nullptr;
+    m_edgeCount = 0;
     m_initialState = InvalidVertexDescriptor;
     m_finalStates.clear();
   }
@@ -534,132 +1445,393 @@ namespace disc {
       g.addEdge(source, target);
     }
 
+    g.finalize();
     return g;
   }
 
-  DerivedGraph buildGraphCrossingOneVertex(const Graph& origin, VertexDescriptor x) {
-    std::size_t count = origin.getVertexCount();
+  Graph Graph::importText(const char *filename) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream in(filename, std::ios::binary);
 
-    auto prime = [count](VertexDescriptor v) -> VertexDescriptor { return { v.index + count }; };
+    if (!in) {
+      std::cerr << "Can not open '" << filename << "'\n";
+      return Graph();
+    }
 
-    DerivedGraph derived(2 * count);
+    // read the whole file in large blocks
 
-    // vertices
+    static constexpr std::size_t BlockSize = 1 << 24;
 
-    for (auto v : origin.getVertices()) {
-      auto id = derived.addVertex(v);
-      assert(id == v);
+    in.seekg(0, std::ios::end);
+    std::size_t size = in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    std::vector<char> buffer(size);
+
+    for (std::size_t offset = 0; offset < size && in; offset += BlockSize) {
+      in.read(&buffer[offset], std::min(BlockSize, size - offset));
     }
 
-    for (auto v : origin.getVertices()) {
-      auto id = derived.addVertex(v);
-      assert(id == prime(v));
+    if (!in) {
+      std::cerr << "Can not read '" << filename << "'\n";
+      return Graph();
     }
 
-    // edges
+    const char *end = buffer.data() + buffer.size();
 
-    for (auto e : origin.getEdges()) {
-      auto source = origin.getSource(e);
-      auto target = origin.getTarget(e);
+    TextScanner header = { buffer.data(), end, false };
+    uint64_t count, init;
 
-      if (source != x) {
-        derived.addEdge(source, target, e);
-      } else {
-        derived.addEdge(source, prime(target), e);
+    if (!header.next(count) || !header.next(init) || init >= count) {
+      std::cerr << "'" << filename << "' has an invalid header\n";
+      return Graph();
+    }
+
+    if (count > MaximumCount) {
+      std::cerr << "'" << filename << "' has too many vertices, build with DISC_INDEX_64\n";
+      return Graph();
+    }
+
+    // split the edges in chunks at line boundaries
+
+    std::size_t chunkCount = std::max(getThreadCount(), std::size_t(1));
+
+    std::vector<const char *> bounds(chunkCount + 1);
+    bounds.front() = header.current;
+    bounds.back() = end;
+
+    for (std::size_t i = 1; i < chunkCount; ++i) {
+      const char *bound = header.current + (end - header.current) * i / chunkCount;
+      bound = std::find(std::max(bound, bounds[i - 1]), end, '\n');
+      bounds[i] = bound == end ? end : bound + 1;
+    }
+
+    // parse the chunks
+
+    std::vector<TextChunk> chunks(chunkCount);
+
+    parallelForEach(chunkCount, [&](std::size_t i) {
+      TextChunk& chunk = chunks[i];
+      chunk.malformed = false;
+      chunk.invalidVertex = count;
+      chunk.ends.reserve((bounds[i + 1] - bounds[i]) / 4);
+
+      TextScanner scanner = { bounds[i], bounds[i + 1], false };
+      uint64_t value;
+
+      while (scanner.next(value)) {
+        if (value >= count) {
+          chunk.invalidVertex = value;
+          return;
+        }
+
+        chunk.ends.push_back(static_cast<Index>(value));
+      }
+
+      chunk.malformed = scanner.malformed || chunk.ends.size() % 2 != 0;
+    });
+
+    std::size_t edgeCount = 0;
+
+    for (auto& chunk : chunks) {
+      if (chunk.malformed) {
+        std::cerr << "'" << filename << "' is malformed\n";
+        return Graph();
+      }
+
+      if (chunk.invalidVertex != count) {
+        std::cerr << "'" << filename << "' has an invalid vertex: " << chunk.invalidVertex << '/' << count << '\n';
+        return Graph();
+      }
+
+      edgeCount += chunk.ends.size() / 2;
+    }
+
+    if (edgeCount > MaximumCount) {
+      std::cerr << "'" << filename << "' has too many edges, build with DISC_INDEX_64\n";
+      return Graph();
+    }
+
+    // counting sort of the edges by source in two passes that keep the
+    // order of the file, with as many ranges of sources as chunks. First the
+    // edges of each chunk are counted in each range and moved to their range,
+    // after the edges of the previous chunks in this range. Then the edges of
+    // each range are sorted by source.
+
+    auto adjacency = std::make_shared<OwnedAdjacency>();
+    auto& offsets = adjacency->offsets;
+    auto& targets = adjacency->targets;
+
+    offsets.assign(count + 1, 0);
+
+    auto getSourceRange = [count, chunkCount](std::size_t i) {
+      return std::make_pair(count * i / chunkCount, count * (i + 1) / chunkCount);
+    };
+
+    // the range of sources that contains a source
+    auto getRangeOf = [count, chunkCount](uint64_t source) {
+      std::size_t range = static_cast<std::size_t>(source * chunkCount / count);
+
+      while (count * (range + 1) / chunkCount <= source) {
+        ++range;
+      }
+
+      while (count * range / chunkCount > source) {
+        --range;
       }
 
-      derived.addEdge(prime(source), prime(target), e);
+      return range;
+    };
+
+    // histograms[i * chunkCount + r] is the number of edges of chunk i in range r
+
+    std::vector<uint64_t> histograms(chunkCount * chunkCount, 0);
+
+    parallelForEach(chunkCount, [&](std::size_t i) {
+      const auto& ends = chunks[i].ends;
+      uint64_t *histogram = &histograms[i * chunkCount];
+
+      for (std::size_t k = 0; k < ends.size(); k += 2) {
+        ++histogram[getRangeOf(ends[k])];
+      }
+    });
+
+    // the edges of a range are stored chunk after chunk
+
+    std::vector<uint64_t> rangeOffsets(chunkCount + 1, 0);
+    uint64_t position = 0;
+
+    for (std::size_t r = 0; r < chunkCount; ++r) {
+      rangeOffsets[r] = position;
+
+      for (std::size_t i = 0; i < chunkCount; ++i) {
+        uint64_t edges = histograms[i * chunkCount + r];
+        histograms[i * chunkCount + r] = position;
+        position += edges;
+      }
     }
 
-    // initial and final states
+    rangeOffsets[chunkCount] = position;
+
+    std::vector<Index> ranged(2 * edgeCount);
 
-    derived.setInitialState(origin.getInitialState());
+    parallelForEach(chunkCount, [&](std::size_t i) {
+      auto& ends = chunks[i].ends;
+      uint64_t *next = &histograms[i * chunkCount];
 
-    for (auto v : origin.getFinalStates()) {
-      derived.addFinalState(prime(v));
+      for (std::size_t k = 0; k < ends.size(); k += 2) {
+        uint64_t edge = next[getRangeOf(ends[k])]++;
+        ranged[2 * edge] = ends[k];
+        ranged[2 * edge + 1] = ends[k + 1];
+      }
+
+      std::vector<Index>().swap(ends);
+    });
+
+    targets.resize(edgeCount);
+
+    // the edges of each range are sorted by source, the ranges are disjoint
+    // so the counts can be written directly in the offsets
 
-      if (v == x) {
-        derived.addFinalState(v);
+    parallelForEach(chunkCount, [&](std::size_t r) {
+      for (uint64_t edge = rangeOffsets[r]; edge < rangeOffsets[r + 1]; ++edge) {
+        ++offsets[ranged[2 * edge] + 1];
       }
+    });
+
+    for (std::size_t i = 1; i < offsets.size(); ++i) {
+      offsets[i] += offsets[i - 1];
     }
 
-    return derived;
+    parallelForEach(chunkCount, [&](std::size_t r) {
+      auto range = getSourceRange(r);
+      std::vector<uint64_t> next(offsets.begin() + range.first, offsets.begin() + range.second);
+
+      for (uint64_t edge = rangeOffsets[r]; edge < rangeOffsets[r + 1]; ++edge) {
+        targets[next[ranged[2 * edge] - range.first]++] = ranged[2 * edge + 1];
+      }
+    });
+
+    Graph g;
+    g.m_vertexCount = count;
+    g.m_finalized = true;
+    g.m_offsets = offsets.data();
+    g.m_targets = targets.data();
+    g.m_edgeCount = edgeCount;
+    g.m_adjacency = std::move(adjacency);
+    g.m_initialState = init;
+    g.m_finalStates.resize(count);
+
+    for (auto v : g.getVertices()) {
+      g.m_finalStates.set(v.index);
+    }
+
+    auto finish = std::chrono::steady_clock::now();
+    std::chrono::duration<double> diff = finish - start;
+    std::cerr << "import: " << edgeCount << " edges in " << diff.count() << "s (" << edgeCount / diff.count() << " edges/s)\n";
+
+    return g;
   }
 
-  DerivedGraph buildGraphCrossingTwoVertices(const Graph& origin, VertexDescriptor x, VertexDescriptor y) {
-    std::size_t count = origin.getVertexCount();
+  Graph Graph::importBinary(const char *filename) {
+    Graph g;
+
+    int fd = open(filename, O_RDONLY);
+
+    if (fd == -1) {
+      std::cerr << "Can not open '" << filename << "'\n";
+      return g;
+    }
 
-    auto prime = [count](VertexDescriptor v) -> VertexDescriptor { return { v.index + count }; };
-    auto doublePrime = [count](VertexDescriptor v) -> VertexDescriptor { return { v.index + 2 * count }; };
-    auto triplePrime = [count](VertexDescriptor v) -> VertexDescriptor { return { v.index + 3 * count }; };
+    struct stat info;
 
-    DerivedGraph derived(4 * count);
+    if (fstat(fd, &info) == -1 || static_cast<std::size_t>(info.st_size) < sizeof(BinaryHeader)) {
+      std::cerr << "Can not read '" << filename << "'\n";
+      close(fd);
+      return g;
+    }
 
-    // vertices
+    std::size_t size = info.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
 
-    for (auto v : origin.getVertices()) {
-      auto id = derived.addVertex(v);
-      assert(id == v);
+    if (data == MAP_FAILED) {
+      std::cerr << "Can not map '" << filename << "'\n";
+      return g;
     }
 
-    for (auto v : origin.getVertices()) {
-      auto id = derived.addVertex(v);
-      assert(id == prime(v));
+    auto adjacency = std::make_shared<MappedAdjacency>();
+    adjacency->data = data;
+    adjacency->size = size;
+
+    const BinaryHeader *header = static_cast<const BinaryHeader *>(data);
+
+    if (!std::equal(std::begin(BinaryMagic), std::end(BinaryMagic), header->magic)) {
+      std::cerr << "'" << filename << "' is not a binary graph\n";
+      return g;
     }
 
-    for (auto v : origin.getVertices()) {
-      auto id = derived.addVertex(v);
-      assert(id == doublePrime(v));
+    if (header->version != BinaryVersion || (header->indexSize != sizeof(uint32_t) && header->indexSize != sizeof(uint64_t))) {
+      std::cerr << "'" << filename << "' has an unsupported binary format\n";
+      return g;
     }
 
-    for (auto v : origin.getVertices()) {
-      auto id = derived.addVertex(v);
-      assert(id == triplePrime(v));
+    if (header->vertexCount > size || header->edgeCount > size || getBinarySize(*header) != size) {
+      std::cerr << "'" << filename << "' is truncated\n";
+      return g;
     }
 
-    // edges
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(header + 1);
+    std::size_t count = header->vertexCount;
+    std::size_t finalWordCount = Bitset::getWordCount(count);
+    const uint64_t *offsets = words + finalWordCount;
 
-    for (auto e : origin.getEdges()) {
-      auto source = origin.getSource(e);
-      auto target = origin.getTarget(e);
+    if (offsets[count] != header->edgeCount) {
+      std::cerr << "'" << filename << "' has inconsistent offsets\n";
+      return g;
+    }
 
-      if (source != x && source != y) {
-        derived.addEdge(source, target, e);
-        derived.addEdge(prime(source), prime(target), e);
-        derived.addEdge(doublePrime(source), doublePrime(target), e);
-      } else {
-        if (source == x) {
-          derived.addEdge(source, prime(target), e);
-          derived.addEdge(prime(source), prime(target), e);
-          derived.addEdge(doublePrime(source), triplePrime(target), e);
-        } else {
-          assert(source == y);
-          derived.addEdge(source, doublePrime(target), e);
-          derived.addEdge(prime(source), triplePrime(target), e);
-          derived.addEdge(doublePrime(source), doublePrime(target), e);
-        }
-      }
+    bool valid = header->indexSize == sizeof(uint32_t)
+      ? isBinaryAdjacencyValid(offsets, reinterpret_cast<const uint32_t *>(offsets + count + 1), count, header->edgeCount)
+      : isBinaryAdjacencyValid(offsets, reinterpret_cast<const uint64_t *>(offsets + count + 1), count, header->edgeCount);
 
-      derived.addEdge(triplePrime(source), triplePrime(target), e);
+    if (!valid) {
+      std::cerr << "'" << filename << "' has inconsistent offsets or targets\n";
+      return g;
     }
 
-    // initial and final states
+    if (count > 0 && header->initialState >= count) {
+      std::cerr << "'" << filename << "' has an invalid initial state\n";
+      return g;
+    }
 
-    derived.setInitialState(origin.getInitialState());
+    g.m_vertexCount = count;
+    g.m_finalized = true;
+    g.m_edgeCount = header->edgeCount;
 
-    for (auto v : origin.getFinalStates()) {
-      derived.addFinalState(triplePrime(v));
+    if (header->indexSize == sizeof(Index)) {
+      g.m_offsets = offsets;
+      g.m_targets = reinterpret_cast<const VertexDescriptor *>(offsets + count + 1);
+      g.m_adjacency = std::move(adjacency);
+    } else {
+      // the file was written with another index size, convert the adjacency
 
-      if (v == x) {
-        derived.addFinalState(doublePrime(v));
+      if (count > MaximumCount || header->edgeCount > MaximumCount) {
+        std::cerr << "'" << filename << "' is too large, build with DISC_INDEX_64\n";
+        return Graph();
       }
 
-      if (v == y) {
-        derived.addFinalState(prime(v));
+      auto converted = std::make_shared<OwnedAdjacency>();
+      converted->offsets.assign(offsets, offsets + count + 1);
+
+      if (header->indexSize == sizeof(uint32_t)) {
+        auto targets = reinterpret_cast<const uint32_t *>(offsets + count + 1);
+        converted->targets.assign(targets, targets + header->edgeCount);
+      } else {
+        auto targets = reinterpret_cast<const uint64_t *>(offsets + count + 1);
+        converted->targets.assign(targets, targets + header->edgeCount);
       }
+
+      g.m_offsets = converted->offsets.data();
+      g.m_targets = converted->targets.data();
+      g.m_adjacency = std::move(converted);
+    }
+    g.m_initialState = header->initialState;
+    g.m_finalStates.resize(count);
+    std::copy(words, words + finalWordCount, g.m_finalStates.getData());
+
+    return g;
+  }
+
+  bool Graph::exportBinary(const char *filename) const {
+    assert(m_finalized);
+
+    std::ofstream out(filename, std::ios::binary);
+
+    if (!out) {
+      std::cerr << "Can not open '" << filename << "'\n";
+      return false;
+    }
+
+    BinaryHeader header;
+    std::copy(std::begin(BinaryMagic), std::end(BinaryMagic), header.magic);
+    header.version = BinaryVersion;
+    header.indexSize = sizeof(Index);
+    header.vertexCount = m_vertexCount;
+    header.edgeCount = m_edgeCount;
+    header.initialState = m_initialState.index;
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof header);
+    out.write(reinterpret_cast<const char *>(m_finalStates.getData()), Bitset::getWordCount(m_vertexCount) * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char *>(m_offsets), (m_vertexCount + 1) * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char *>(m_targets), m_edgeCount * sizeof(VertexDescriptor));
+
+    if (!out) {
+      std::cerr << "Can not write '" << filename << "'\n";
+      return false;
+    }
+
+    return true;
+  }
+
+  Graph Graph::importFile(const char *filename) {
+    std::ifstream in(filename, std::ios::binary);
+
+    if (!in) {
+      std::cerr << "Can not open '" << filename << "'\n";
+      return Graph();
+    }
+
+    char magic[sizeof BinaryMagic];
+
+    if (in.read(magic, sizeof magic) && std::equal(std::begin(BinaryMagic), std::end(BinaryMagic), magic)) {
+      in.close();
+      return importBinary(filename);
     }
 
-    return derived;
+    in.close();
+    return importText(filename);
   }
 
 }
@@ -0,0 +1,271 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <disc/graph/Order.h>
+
+#include <cassert>
+
+#include <algorithm>
+#include <deque>
+
+namespace disc {
+
+  namespace {
+
+    std::vector<VertexDescriptor> computeBreadthFirstOrder(const Graph& g) {
+      std::size_t count = g.getVertexCount();
+
+      std::vector<VertexDescriptor> order;
+      order.reserve(count);
+
+      std::vector<bool> visited(count, false);
+
+      auto visit = [&](VertexDescriptor start) {
+        order.push_back(start);
+        visited[start.index] = true;
+
+        for (std::size_t i = order.size() - 1; i < order.size(); ++i) {
+          for (auto next : g.getSuccessors(order[i])) {
+            if (!visited[next.index]) {
+              order.push_back(next);
+              visited[next.index] = true;
+            }
+          }
+        }
+      };
+
+      if (g.getInitialState() != InvalidVertexDescriptor) {
+        visit(g.getInitialState());
+      }
+
+      // unreachable vertices
+      for (auto v : g.getVertices()) {
+        if (!visited[v.index]) {
+          visit(v);
+        }
+      }
+
+      return order;
+    }
+
+    std::vector<VertexDescriptor> computeReverseCuthillMcKeeOrder(const Graph& g) {
+      std::size_t count = g.getVertexCount();
+
+      // undirected adjacency
+
+      std::vector<std::size_t> offsets(count + 1, 0);
+
+      for (auto v : g.getVertices()) {
+        for (auto next : g.getSuccessors(v)) {
+          ++offsets[v.index + 1];
+          ++offsets[next.index + 1];
+        }
+      }
+
+      for (std::size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+      }
+
+      std::vector<VertexDescriptor> neighbors(offsets.back());
+      std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+
+      for (auto v : g.getVertices()) {
+        for (auto w : g.getSuccessors(v)) {
+          neighbors[next[v.index]++] = w;
+          neighbors[next[w.index]++] = v;
+        }
+      }
+
+      auto degree = [&offsets](VertexDescriptor v) {
+        return offsets[v.index + 1] - offsets[v.index];
+      };
+
+      auto byDegree = [&degree](VertexDescriptor lhs, VertexDescriptor rhs) {
+        return degree(lhs) < degree(rhs);
+      };
+
+      // Cuthill-McKee, starting each component from a vertex of minimum degree
+
+      std::vector<VertexDescriptor> starts;
+      starts.reserve(count);
+
+      for (auto v : g.getVertices()) {
+        starts.push_back(v);
+      }
+
+      std::stable_sort(starts.begin(), starts.end(), byDegree);
+
+      std::vector<VertexDescriptor> order;
+      order.reserve(count);
+
+      std::vector<bool> visited(count, false);
+
+      for (auto start : starts) {
+        if (visited[start.index]) {
+          continue;
+        }
+
+        order.push_back(start);
+        visited[start.index] = true;
+
+        for (std::size_t i = order.size() - 1; i < order.size(); ++i) {
+          VertexDescriptor v = order[i];
+          std::size_t first = order.size();
+
+          for (std::size_t k = offsets[v.index]; k < offsets[v.index + 1]; ++k) {
+            VertexDescriptor w = neighbors[k];
+
+            if (!visited[w.index]) {
+              order.push_back(w);
+              visited[w.index] = true;
+            }
+          }
+
+          std::stable_sort(order.begin() + first, order.end(), byDegree);
+        }
+      }
+
+      std::reverse(order.begin(), order.end());
+      return order;
+    }
+
+    std::vector<VertexDescriptor> computeDegreeOrder(const Graph& g) {
+      std::size_t count = g.getVertexCount();
+
+      std::vector<std::size_t> degrees(count, 0);
+
+      for (auto v : g.getVertices()) {
+        for (auto next : g.getSuccessors(v)) {
+          ++degrees[v.index];
+          ++degrees[next.index];
+        }
+      }
+
+      std::vector<VertexDescriptor> order;
+      order.reserve(count);
+
+      for (auto v : g.getVertices()) {
+        order.push_back(v);
+      }
+
+      std::stable_sort(order.begin(), order.end(), [&degrees](VertexDescriptor lhs, VertexDescriptor rhs) {
+        return degrees[lhs.index] > degrees[rhs.index];
+      });
+
+      return order;
+    }
+
+  }
+
+  bool parseVertexOrder(const std::string& name, VertexOrder& order) {
+    if (name == "none") {
+      order = VertexOrder::None;
+    } else if (name == "bfs") {
+      order = VertexOrder::BreadthFirst;
+    } else if (name == "rcm") {
+      order = VertexOrder::ReverseCuthillMcKee;
+    } else if (name == "degree") {
+      order = VertexOrder::Degree;
+    } else {
+      return false;
+    }
+
+    return true;
+  }
+
+  std::vector<VertexDescriptor> computeVertexOrder(const Graph& g, VertexOrder order) {
+    switch (order) {
+      case VertexOrder::None:
+        break;
+      case VertexOrder::BreadthFirst:
+        return computeBreadthFirstOrder(g);
+      case VertexOrder::ReverseCuthillMcKee:
+        return computeReverseCuthillMcKeeOrder(g);
+      case VertexOrder::Degree:
+        return computeDegreeOrder(g);
+    }
+
+    std::vector<VertexDescriptor> identity;
+    identity.reserve(g.getVertexCount());
+
+    for (auto v : g.getVertices()) {
+      identity.push_back(v);
+    }
+
+    return identity;
+  }
+
+  Graph permuteGraph(const Graph& g, const std::vector<VertexDescriptor>& order) {
+    std::size_t count = g.getVertexCount();
+    assert(order.size() == count);
+
+    std::vector<VertexDescriptor> rank(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      rank[order[i].index] = { i };
+    }
+
+    Graph permuted(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      permuted.addVertex();
+    }
+
+    for (auto v : permuted.getVertices()) {
+      for (auto next : g.getSuccessors(order[v.index])) {
+        permuted.addEdge(v, rank[next.index]);
+      }
+    }
+
+    permuted.finalize();
+
+    for (auto v : permuted.getVertices()) {
+      if (g.isFinalState(order[v.index])) {
+        permuted.addFinalState(v);
+      }
+    }
+
+    if (g.getInitialState() != InvalidVertexDescriptor) {
+      permuted.setInitialState(rank[g.getInitialState().index]);
+    }
+
+    return permuted;
+  }
+
+  std::vector<VertexDescriptor> restoreVertexOrder(const std::vector<VertexDescriptor>& path, const std::vector<VertexDescriptor>& order) {
+    std::vector<VertexDescriptor> res;
+    res.reserve(path.size());
+
+    for (auto v : path) {
+      res.push_back(order[v.index]);
+    }
+
+    return res;
+  }
+
+  std::vector<double> restoreVertexOrder(const std::vector<double>& values, const std::vector<VertexDescriptor>& order) {
+    assert(values.size() == order.size());
+    std::vector<double> res(values.size());
+
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      res[order[i].index] = values[i];
+    }
+
+    return res;
+  }
+
+}
@@ -0,0 +1,324 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <disc/graph/Parallel.h>
+
+#include <cassert>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+namespace disc {
+
+  namespace {
+
+    // minimum number of items handled by a thread in a loop
+    constexpr std::size_t Grain = 1024;
+
+    // number of checks before a thread sleeps in a barrier
+    constexpr std::size_t SpinCount = 1 << 14;
+
+    // number of reports of a progress
+    constexpr std::size_t ProgressSteps = 1000;
+
+    thread_local bool g_worker = false;
+
+    std::mutex g_poolMutex;
+    std::size_t g_threads = 1;
+    std::unique_ptr<ThreadPool> g_pool;
+
+  }
+
+  /*
+   * Barrier
+   */
+
+  Barrier::Barrier(std::size_t threads)
+  : m_threads(threads)
+  , m_waiting(0)
+  , m_generation(0)
+  {
+  }
+
+  void Barrier::wait() {
+    uint64_t generation = m_generation.load(std::memory_order_acquire);
+
+    if (m_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == m_threads) {
+      m_waiting.store(0, std::memory_order_relaxed);
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation.store(generation + 1, std::memory_order_release);
+      }
+
+      m_condition.notify_all();
+      return;
+    }
+
+    for (std::size_t i = 0; i < SpinCount; ++i) {
+      if (m_generation.load(std::memory_order_acquire) != generation) {
+        return;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [&]() { return m_generation.load(std::memory_order_acquire) != generation; });
+  }
+
+  /*
+   * ThreadPool
+   */
+
+  ThreadPool::ThreadPool(std::size_t threads)
+  : m_task(nullptr)
+  , m_threads(0)
+  , m_pending(0)
+  , m_generation(0)
+  , m_stop(false)
+  {
+    for (std::size_t i = 1; i < threads; ++i) {
+      m_workers.emplace_back(&ThreadPool::work, this, i);
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+
+    m_start.notify_all();
+
+    for (auto& worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  void ThreadPool::run(std::size_t threads, const std::function<void(std::size_t)>& func) {
+    assert(threads <= getThreadCount());
+
+    if (threads <= 1 || isWorkerThread()) {
+      for (std::size_t i = 0; i < threads; ++i) {
+        func(i);
+      }
+
+      return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submit);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_task = &func;
+      m_threads = threads;
+      m_pending = threads - 1;
+      ++m_generation;
+    }
+
+    m_start.notify_all();
+
+    g_worker = true;
+    func(0);
+    g_worker = false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&]() { return m_pending == 0; });
+    m_task = nullptr;
+  }
+
+  bool ThreadPool::isWorkerThread() {
+    return g_worker;
+  }
+
+  void ThreadPool::work(std::size_t i) {
+    g_worker = true;
+    uint64_t generation = 0;
+
+    for (;;) {
+      const std::function<void(std::size_t)> *task;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_start.wait(lock, [&]() { return m_stop || m_generation != generation; });
+
+        if (m_stop) {
+          return;
+        }
+
+        generation = m_generation;
+
+        if (i >= m_threads) {
+          continue;
+        }
+
+        task = m_task;
+      }
+
+      (*task)(i);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (--m_pending == 0) {
+        m_done.notify_one();
+      }
+    }
+  }
+
+  /*
+   * WorkStealingQueue
+   */
+
+  WorkStealingQueue::WorkStealingQueue(std::size_t count, std::size_t threads)
+  : m_ranges(threads)
+  {
+    for (std::size_t i = 0; i < threads; ++i) {
+      m_ranges[i].begin = count * i / threads;
+      m_ranges[i].end = count * (i + 1) / threads;
+    }
+  }
+
+  bool WorkStealingQueue::pop(std::size_t thread, std::size_t& item) {
+    assert(thread < m_ranges.size());
+
+    {
+      Range& own = m_ranges[thread];
+      std::lock_guard<std::mutex> lock(own.mutex);
+
+      if (own.begin < own.end) {
+        item = own.begin++;
+        return true;
+      }
+    }
+
+    // the ranges only shrink, so the items are all handed out when every
+    // range is empty
+
+    for (;;) {
+      std::size_t victim = m_ranges.size();
+      std::size_t largest = 0;
+
+      for (std::size_t i = 0; i < m_ranges.size(); ++i) {
+        std::lock_guard<std::mutex> lock(m_ranges[i].mutex);
+        std::size_t remaining = m_ranges[i].end - m_ranges[i].begin;
+
+        if (remaining > largest) {
+          victim = i;
+          largest = remaining;
+        }
+      }
+
+      if (victim == m_ranges.size()) {
+        return false;
+      }
+
+      std::size_t begin, end;
+
+      {
+        Range& other = m_ranges[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+
+        if (other.begin == other.end) {
+          continue;
+        }
+
+        begin = other.begin + (other.end - other.begin) / 2;
+        end = other.end;
+        other.end = begin;
+      }
+
+      Range& own = m_ranges[thread];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      own.begin = begin + 1;
+      own.end = end;
+      item = begin;
+      return true;
+    }
+  }
+
+  /*
+   * Progress
+   */
+
+  Progress::Progress(std::size_t total)
+  : m_total(total)
+  , m_done(0)
+  , m_printed(0)
+  {
+  }
+
+  void Progress::add(std::size_t count) {
+    std::size_t done = m_done.fetch_add(count) + count;
+
+    if ((done - count) * ProgressSteps / m_total == done * ProgressSteps / m_total) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (done > m_printed) {
+      std::cout << '\r' << done << '/' << m_total << std::flush;
+      m_printed = done;
+    }
+  }
+
+  void Progress::finish() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::cout << '\r' << m_done.load() << '/' << m_total << '\n';
+  }
+
+  /*
+   * global pool
+   */
+
+  void setThreadCount(std::size_t threads) {
+    if (threads == 0) {
+      threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    std::lock_guard<std::mutex> lock(g_poolMutex);
+
+    if (threads != g_threads) {
+      g_threads = threads;
+      g_pool.reset();
+    }
+  }
+
+  std::size_t getThreadCount() {
+    std::lock_guard<std::mutex> lock(g_poolMutex);
+    return g_threads;
+  }
+
+  ThreadPool& getThreadPool() {
+    std::lock_guard<std::mutex> lock(g_poolMutex);
+
+    if (!g_pool) {
+      g_pool.reset(new ThreadPool(g_threads));
+    }
+
+    return *g_pool;
+  }
+
+  std::size_t getLoopThreadCount(std::size_t count) {
+    if (ThreadPool::isWorkerThread()) {
+      return 1;
+    }
+
+    return std::max(std::min(getThreadCount(), count / Grain), std::size_t(1));
+  }
+
+}
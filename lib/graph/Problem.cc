@@ -18,20 +18,660 @@
 #include <disc/graph/Problem.h>
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <climits>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <numeric>
 
 #include <glpk.h>
 
+#include <disc/graph/Parallel.h>
+
 namespace disc {
 
-  std::vector<double> computePii(const Matrix<double>& coeffs, const char *filename) {
-    assert(coeffs.getCols() == coeffs.getRows());
+  namespace {
+
+    // bound on the candidates compared to a column when looking for a
+    // dominating column, and bound on the passes of the reduction, as each
+    // pass may find new identical or dominated columns
+    constexpr std::size_t ReductionCandidates = 1024;
+    constexpr std::size_t ReductionPasses = 16;
+
+    // the mirror prox prints its bounds every MirrorProxReport iterations,
+    // its step grows after an accepted iteration and shrinks after a
+    // rejected one
+    constexpr std::size_t MirrorProxReport = 1000;
+    constexpr double MirrorProxGrowth = 1.25;
+    constexpr double MirrorProxShrink = 0.5;
+
+    uint64_t computeColumnHash(const SparseMatrix<double>& m, std::size_t j) {
+      uint64_t hash = UINT64_C(14695981039346656037);
+
+      auto combine = [&hash](uint64_t x) {
+        hash = (hash ^ x) * UINT64_C(1099511628211);
+      };
+
+      for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+        double value = m.getValue(k);
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        combine(m.getRow(k));
+        combine(bits);
+      }
+
+      return hash;
+    }
+
+    bool isColumnEqual(const SparseMatrix<double>& m, std::size_t lhs, std::size_t rhs) {
+      std::size_t k = m.getColumnBegin(lhs);
+      std::size_t l = m.getColumnBegin(rhs);
+
+      if (m.getColumnEnd(lhs) - k != m.getColumnEnd(rhs) - l) {
+        return false;
+      }
+
+      for (; k < m.getColumnEnd(lhs); ++k, ++l) {
+        if (m.getRow(k) != m.getRow(l) || m.getValue(k) != m.getValue(l)) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    // every entry of the column lhs is less than the entry of the column rhs
+    bool isColumnLess(const SparseMatrix<double>& m, std::size_t lhs, std::size_t rhs) {
+      std::size_t l = m.getColumnBegin(rhs);
+
+      for (std::size_t k = m.getColumnBegin(lhs); k < m.getColumnEnd(lhs); ++k) {
+        while (l < m.getColumnEnd(rhs) && m.getRow(l) < m.getRow(k)) {
+          ++l;
+        }
+
+        if (l == m.getColumnEnd(rhs) || m.getRow(l) != m.getRow(k) || m.getValue(l) < m.getValue(k)) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    // calls func on the active columns other than j that are greater than the
+    // column j, until func returns false, t is the transpose of m
+    template<typename Func>
+    void forEachGreaterColumn(const SparseMatrix<double>& m, const SparseMatrix<double>& t, const std::vector<double>& sums, const std::vector<bool>& active, std::size_t j, Func func) {
+      if (m.getColumnBegin(j) == m.getColumnEnd(j)) {
+        // a zero column is less than any column
+        for (std::size_t other = 0; other < m.getCols(); ++other) {
+          if (other != j && active[other] && !func(other)) {
+            return;
+          }
+        }
+
+        return;
+      }
+
+      // a greater column has an entry in every row of the column, so the
+      // candidates are the columns of the row with the fewest entries
+      std::size_t row = m.getRow(m.getColumnBegin(j));
+
+      for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+        std::size_t candidate = m.getRow(k);
+
+        if (t.getColumnEnd(candidate) - t.getColumnBegin(candidate) < t.getColumnEnd(row) - t.getColumnBegin(row)) {
+          row = candidate;
+        }
+      }
+
+      if (t.getColumnEnd(row) - t.getColumnBegin(row) > ReductionCandidates) {
+        return;
+      }
+
+      for (std::size_t k = t.getColumnBegin(row); k < t.getColumnEnd(row); ++k) {
+        std::size_t other = t.getRow(k);
+
+        // the coefficients are nonnegative, so a greater column has a greater sum
+        if (other == j || !active[other] || sums[other] < sums[j] || !isColumnLess(m, j, other)) {
+          continue;
+        }
+
+        if (!func(other)) {
+          return;
+        }
+      }
+    }
+
+    // returns for each column the column that replaces it: the first of the
+    // identical columns, or NoReducedColumn if the column is removed. If less
+    // is true, the columns that are less than another column are removed,
+    // otherwise the columns that are greater than another column are removed.
+    std::vector<std::size_t> reduceColumns(const SparseMatrix<double>& m, bool less) {
+      std::size_t cols = m.getCols();
+
+      // identical columns
+
+      std::vector<uint64_t> hashes(cols);
+
+      for (std::size_t j = 0; j < cols; ++j) {
+        hashes[j] = computeColumnHash(m, j);
+      }
+
+      std::vector<std::size_t> sorted(cols);
+      std::iota(sorted.begin(), sorted.end(), 0);
+      std::sort(sorted.begin(), sorted.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return hashes[lhs] < hashes[rhs] || (hashes[lhs] == hashes[rhs] && lhs < rhs);
+      });
+
+      std::vector<std::size_t> kept(cols);
+
+      for (std::size_t first = 0; first < cols; ) {
+        std::size_t last = first;
+
+        while (last < cols && hashes[sorted[last]] == hashes[sorted[first]]) {
+          ++last;
+        }
+
+        for (std::size_t l = first; l < last; ++l) {
+          std::size_t j = sorted[l];
+          kept[j] = j;
+
+          for (std::size_t p = first; p < l; ++p) {
+            std::size_t other = sorted[p];
+
+            if (kept[other] == other && isColumnEqual(m, other, j)) {
+              kept[j] = other;
+              break;
+            }
+          }
+        }
+
+        first = last;
+      }
+
+      // dominated columns, the order is strict between the remaining columns
+
+      std::vector<bool> active(cols);
+      std::vector<double> sums(cols, 0.0);
+
+      for (std::size_t j = 0; j < cols; ++j) {
+        active[j] = kept[j] == j;
+
+        for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+          sums[j] += m.getValue(k);
+        }
+      }
+
+      auto t = matrixTranspose(m);
+
+      for (std::size_t j = 0; j < cols; ++j) {
+        if (!active[j]) {
+          continue;
+        }
+
+        if (less) {
+          forEachGreaterColumn(m, t, sums, active, j, [&](std::size_t) {
+            active[j] = false;
+            return false;
+          });
+        } else {
+          forEachGreaterColumn(m, t, sums, active, j, [&](std::size_t other) {
+            active[other] = false;
+            return true;
+          });
+        }
+      }
+
+      for (std::size_t j = 0; j < cols; ++j) {
+        if (kept[j] == j && !active[j]) {
+          kept[j] = NoReducedColumn;
+        } else if (kept[j] != j && !active[kept[j]]) {
+          kept[j] = NoReducedColumn;
+        }
+      }
+
+      return kept;
+    }
+
+    // keeps the columns that are not replaced and returns the new index of
+    // each column
+    std::vector<std::size_t> keepColumns(SparseMatrix<double>& m, const std::vector<std::size_t>& kept) {
+      std::vector<std::size_t> index(m.getCols(), NoReducedColumn);
+      SparseMatrix<double> res(m.getRows());
+
+      for (std::size_t j = 0; j < m.getCols(); ++j) {
+        if (kept[j] == NoReducedColumn) {
+          continue;
+        }
+
+        if (kept[j] != j) {
+          assert(kept[j] < j);
+          index[j] = index[kept[j]];
+          continue;
+        }
+
+        index[j] = res.getCols();
+        res.addColumn();
+
+        for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+          res.addEntry(m.getRow(k), m.getValue(k));
+        }
+      }
+
+      m.swap(res);
+      return index;
+    }
+
+    // the probability of each vertex: p_i = sum_j coeffs(i, j) * pi_j
+    std::vector<double> computeProbabilities(const SparseMatrix<double>& coeffs, const std::vector<double>& pi) {
+      std::vector<double> probabilities(coeffs.getRows(), 0.0);
+
+      for (std::size_t j = 0; j < coeffs.getCols(); ++j) {
+        for (std::size_t k = coeffs.getColumnBegin(j); k < coeffs.getColumnEnd(j); ++k) {
+          probabilities[coeffs.getRow(k)] += coeffs.getValue(k) * pi[j];
+        }
+      }
+
+      return probabilities;
+    }
+
+    // any distribution is feasible as the coefficients are nonnegative, so a
+    // point is made feasible by removing its negative components and scaling
+    // it, returns false if nothing is left
+    bool makeFeasible(std::vector<double>& pi) {
+      double sum = 0;
+
+      for (auto& x : pi) {
+        x = std::max(x, 0.0);
+        sum += x;
+      }
+
+      if (!(sum > 0)) {
+        return false;
+      }
+
+      for (auto& x : pi) {
+        x /= sum;
+      }
+
+      return true;
+    }
+
+    // y = transpose(m) * x, in parallel
+    void multiplyTranspose(const SparseMatrix<double>& m, const std::vector<double>& x, std::vector<double>& y) {
+      parallelFor(m.getCols(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t j = begin; j < end; ++j) {
+          double sum = 0;
+
+          for (std::size_t k = m.getColumnBegin(j); k < m.getColumnEnd(j); ++k) {
+            sum += m.getValue(k) * x[m.getRow(k)];
+          }
+
+          y[j] = sum;
+        }
+      });
+    }
+
+    // the distributions are kept as logarithms so that small probabilities
+    // do not vanish: next = log(softmax(base + step * gradient))
+    void updateDistribution(const std::vector<double>& base, const std::vector<double>& gradient, double step, std::vector<double>& next, std::vector<double>& probabilities) {
+      double top = -std::numeric_limits<double>::infinity();
+
+      for (std::size_t i = 0; i < base.size(); ++i) {
+        next[i] = base[i] + step * gradient[i];
+        top = std::max(top, next[i]);
+      }
+
+      double sum = 0;
+
+      for (std::size_t i = 0; i < base.size(); ++i) {
+        sum += std::exp(next[i] - top);
+      }
+
+      double norm = top + std::log(sum);
+
+      for (std::size_t i = 0; i < base.size(); ++i) {
+        next[i] -= norm;
+        probabilities[i] = std::exp(next[i]);
+      }
+    }
+
+    // Kullback-Leibler divergence of the distribution next from prev
+    double computeDivergence(const std::vector<double>& next, const std::vector<double>& probabilities, const std::vector<double>& prev) {
+      double divergence = 0;
+
+      for (std::size_t i = 0; i < next.size(); ++i) {
+        divergence += probabilities[i] * (next[i] - prev[i]);
+      }
+
+      return divergence;
+    }
+
+    double computeDifferenceProduct(const std::vector<double>& a1, const std::vector<double>& a0, const std::vector<double>& b1, const std::vector<double>& b0) {
+      double product = 0;
+
+      for (std::size_t i = 0; i < a1.size(); ++i) {
+        product += (a1[i] - a0[i]) * (b1[i] - b0[i]);
+      }
+
+      return product;
+    }
+
+    /*
+     * Mirror prox with entropic prox functions (Nemirovski, 2004) on the game
+     * max_pi min_w w.A.pi. An iteration goes from z = (pi, w) to an
+     * extrapolated point z' with the gradients at z, then to the next point
+     * z+ from z with the gradients at z'. The step is accepted if
+     *   step.<F(z') - F(z), z' - z+> <= KL(z' | z) + KL(z+ | z')
+     * where F(z) = (-A^T.w, A.pi), which holds for step <= 1 / max|A_ij|.
+     * The bounds come from the averages of the extrapolated points, weighted
+     * by the steps.
+     */
+    std::vector<double> solveMirrorProx(const SparseMatrix<double>& coeffs, const LpOptions& options) {
+      std::size_t rows = coeffs.getRows();
+      std::size_t size = coeffs.getCols();
+
+      if (rows == 0 || size == 0) {
+        return std::vector<double>(size, size == 0 ? 0.0 : 1.0 / size);
+      }
+
+      auto transpose = matrixTranspose(coeffs);
+
+      double largest = 0;
+
+      for (std::size_t k = 0; k < coeffs.getNonZeroCount(); ++k) {
+        largest = std::max(largest, std::abs(coeffs.getValue(k)));
+      }
+
+      if (largest == 0) {
+        return std::vector<double>(size, 1.0 / size);
+      }
+
+      // starting points, a warm start is mixed with the uniform distribution
+      // so that every pi_i can still grow
+
+      std::vector<double> pi(size, 1.0 / size);
+      std::vector<double> w(rows, 1.0 / rows);
+
+      if (!options.start.empty()) {
+        std::vector<double> start = options.start;
+
+        if (makeFeasible(start)) {
+          for (std::size_t j = 0; j < size; ++j) {
+            pi[j] = (start[j] + pi[j]) / 2;
+          }
+        }
+      }
+
+      std::vector<double> logPi(size), logW(rows);
+
+      for (std::size_t j = 0; j < size; ++j) {
+        logPi[j] = std::log(pi[j]);
+      }
+
+      for (std::size_t i = 0; i < rows; ++i) {
+        logW[i] = std::log(w[i]);
+      }
+
+      std::vector<double> piMid(size), logPiMid(size), piNext(size), logPiNext(size);
+      std::vector<double> wMid(rows), logWMid(rows), wNext(rows), logWNext(rows);
+      std::vector<double> productPi(rows), productW(size), productPiMid(rows), productWMid(size), negative(rows);
+
+      std::vector<double> sumPi(size, 0.0), sumProductPi(rows, 0.0), sumProductW(size, 0.0);
+      double total = 0;
+
+      double minimum = 1 / largest;
+      double step = minimum;
+      double lower = 0;
+      double upper = std::numeric_limits<double>::infinity();
+
+      auto start = std::chrono::steady_clock::now();
+      std::size_t iteration = 0;
+
+      multiplyTranspose(transpose, pi, productPi);
+      multiplyTranspose(coeffs, w, productW);
+
+      while (iteration < options.iterations) {
+        // extrapolation
+
+        for (std::size_t i = 0; i < rows; ++i) {
+          negative[i] = -productPi[i];
+        }
+
+        updateDistribution(logPi, productW, step, logPiMid, piMid);
+        updateDistribution(logW, negative, step, logWMid, wMid);
+
+        multiplyTranspose(transpose, piMid, productPiMid);
+        multiplyTranspose(coeffs, wMid, productWMid);
+
+        // step
+
+        for (std::size_t i = 0; i < rows; ++i) {
+          negative[i] = -productPiMid[i];
+        }
+
+        updateDistribution(logPi, productWMid, step, logPiNext, piNext);
+        updateDistribution(logW, negative, step, logWNext, wNext);
+
+        double variation = -computeDifferenceProduct(productWMid, productW, piMid, piNext) + computeDifferenceProduct(productPiMid, productPi, wMid, wNext);
+        double divergence = computeDivergence(logPiMid, piMid, logPi) + computeDivergence(logWMid, wMid, logW) + computeDivergence(logPiNext, piNext, logPiMid) + computeDivergence(logWNext, wNext, logWMid);
+
+        if (step * variation > divergence && step > minimum) {
+          step = std::max(step * MirrorProxShrink, minimum);
+          continue;
+        }
+
+        ++iteration;
+
+        for (std::size_t j = 0; j < size; ++j) {
+          sumPi[j] += step * piMid[j];
+          sumProductW[j] += step * productWMid[j];
+        }
+
+        for (std::size_t i = 0; i < rows; ++i) {
+          sumProductPi[i] += step * productPiMid[i];
+        }
+
+        total += step;
+
+        lower = *std::min_element(sumProductPi.begin(), sumProductPi.end()) / total;
+        upper = *std::max_element(sumProductW.begin(), sumProductW.end()) / total;
+
+        bool done = upper - lower <= options.accuracy * upper;
+
+        if (!done && options.timeLimit > 0) {
+          std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+          done = elapsed.count() > options.timeLimit;
+        }
+
+        if (done || iteration % MirrorProxReport == 0) {
+          std::cout << "iteration " << iteration << ": " << lower << " <= p_min <= " << upper << " (step: " << step << ")\n";
+        }
+
+        if (done) {
+          break;
+        }
+
+        logPi.swap(logPiNext);
+        pi.swap(piNext);
+        logW.swap(logWNext);
+        w.swap(wNext);
+
+        multiplyTranspose(transpose, pi, productPi);
+        multiplyTranspose(coeffs, w, productW);
+
+        step *= MirrorProxGrowth;
+      }
+
+      if (total == 0) {
+        return pi;
+      }
+
+      if (upper - lower > options.accuracy * upper) {
+        std::cerr << "Mirror prox stopped before the accuracy, p_min in [" << lower << ", " << upper << "]\n";
+      }
+
+      for (auto& x : sumPi) {
+        x /= total;
+      }
+
+      return sumPi;
+    }
+
+    // builds a basis from a previous pi: the positive pi_i and p_min are
+    // basic, with the rows of the largest slacks so that the basis has as
+    // many variables as rows
+    void setWarmBasis(glp_prob *prob, const SparseMatrix<double>& coeffs, const std::vector<double>& start) {
+      std::size_t size = coeffs.getCols();
+      std::size_t rows = coeffs.getRows();
+      std::vector<double> pi = start;
+
+      if (!makeFeasible(pi)) {
+        std::cerr << "Invalid warm start, cold start\n";
+        return;
+      }
+
+      auto probabilities = computeProbabilities(coeffs, pi);
+      double pmin = *std::min_element(probabilities.begin(), probabilities.end());
+
+      // at most one basic pi_i per row, the largest ones
+      std::vector<std::size_t> cols(size);
+      std::iota(cols.begin(), cols.end(), 0);
+      std::stable_sort(cols.begin(), cols.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return pi[lhs] > pi[rhs];
+      });
+
+      std::size_t basic = 0;
+
+      for (auto j : cols) {
+        if (pi[j] > 0 && basic < rows) {
+          glp_set_col_stat(prob, j + 1, GLP_BS);
+          ++basic;
+        } else {
+          glp_set_col_stat(prob, j + 1, GLP_NL);
+        }
+      }
+
+      glp_set_col_stat(prob, size + 1, GLP_BS);
+
+      std::vector<std::size_t> order(rows);
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return probabilities[lhs] > probabilities[rhs];
+      });
+
+      for (std::size_t l = 0; l < rows; ++l) {
+        glp_set_row_stat(prob, order[l] + 1, l < rows - basic ? GLP_BS : GLP_NL);
+      }
+
+      glp_set_row_stat(prob, rows + 1, GLP_NS);
+
+      if (glp_warm_up(prob) != 0) {
+        std::cerr << "Singular warm start basis, advanced basis\n";
+        glp_adv_basis(prob, 0);
+      } else {
+        std::cout << "warm start from p_min = " << pmin << '\n';
+      }
+    }
+
+  }
+
+  MaxMinReduction reduceMaxMinProblem(const SparseMatrix<double>& coeffs) {
+    MaxMinReduction reduction;
+    reduction.coeffs = coeffs;
+    reduction.columns.resize(coeffs.getCols());
+    std::iota(reduction.columns.begin(), reduction.columns.end(), 0);
+
+    for (std::size_t pass = 0; pass < ReductionPasses; ++pass) {
+      std::size_t rows = reduction.coeffs.getRows();
+      std::size_t cols = reduction.coeffs.getCols();
+
+      auto index = keepColumns(reduction.coeffs, reduceColumns(reduction.coeffs, true));
+
+      for (auto& col : reduction.columns) {
+        if (col != NoReducedColumn) {
+          col = index[col];
+        }
+      }
+
+      auto transpose = matrixTranspose(reduction.coeffs);
+      keepColumns(transpose, reduceColumns(transpose, false));
+      reduction.coeffs = matrixTranspose(transpose);
+
+      if (reduction.coeffs.getRows() == rows && reduction.coeffs.getCols() == cols) {
+        break;
+      }
+    }
+
+    reduction.counts.assign(reduction.coeffs.getCols(), 0);
+
+    for (auto col : reduction.columns) {
+      if (col != NoReducedColumn) {
+        ++reduction.counts[col];
+      }
+    }
+
+    return reduction;
+  }
+
+  std::vector<double> reduceMaxMinSolution(const MaxMinReduction& reduction, const std::vector<double>& pi) {
+    assert(pi.size() == reduction.columns.size());
+    std::vector<double> res(reduction.coeffs.getCols(), 0.0);
+
+    for (std::size_t j = 0; j < pi.size(); ++j) {
+      if (reduction.columns[j] != NoReducedColumn) {
+        res[reduction.columns[j]] += pi[j];
+      }
+    }
+
+    return res;
+  }
+
+  std::vector<double> expandMaxMinSolution(const MaxMinReduction& reduction, const std::vector<double>& pi) {
+    assert(pi.size() == reduction.coeffs.getCols());
+    std::vector<double> res(reduction.columns.size(), 0.0);
+
+    for (std::size_t j = 0; j < res.size(); ++j) {
+      std::size_t col = reduction.columns[j];
+
+      if (col != NoReducedColumn) {
+        res[j] = pi[col] / reduction.counts[col];
+      }
+    }
+
+    return res;
+  }
+
+  std::vector<double> computePii(const SparseMatrix<double>& coeffs, const char *filename, const LpOptions& options) {
+    if (options.reduce) {
+      auto reduction = reduceMaxMinProblem(coeffs);
+      std::cout << "reduced problem: " << reduction.coeffs.getRows() << " rows, " << reduction.coeffs.getCols() << " columns (from " << coeffs.getRows() << " rows, " << coeffs.getCols() << " columns)\n";
+
+      LpOptions reduced = options;
+      reduced.reduce = false;
+
+      if (!options.start.empty()) {
+        reduced.start = reduceMaxMinSolution(reduction, options.start);
+      }
+
+      return expandMaxMinSolution(reduction, computePii(reduction.coeffs, filename, reduced));
+    }
+
+    if (options.method == LpMethod::MirrorProx) {
+      std::cout << "computing pi_i with the mirror prox\n";
+      return solveMirrorProx(coeffs, options);
+    }
 
     std::cout << "computing pi_i\n";
 
     std::size_t size = coeffs.getCols();
+    std::size_t rows = coeffs.getRows();
 
     glp_prob *prob = glp_create_prob();
     glp_set_prob_name(prob, "Pi_i");
@@ -43,10 +683,10 @@ namespace disc {
 
     // rows
 
-    std::size_t nrows = size + 1;
+    std::size_t nrows = rows + 1;
     glp_add_rows(prob, nrows);
 
-    for (std::size_t i = 0; i < size; ++i) {
+    for (std::size_t i = 0; i < rows; ++i) {
       int row = i + 1;
       std::snprintf(buffer.data(), buffer.size(), "p_%i", (row - 1));
       glp_set_row_name(prob, row, buffer.data());
@@ -84,11 +724,18 @@ namespace disc {
     ja.push_back(0);
     ar.push_back(0.);
 
+    // only the nonzero coefficients are loaded
+
+    std::size_t entries = 1 + coeffs.getNonZeroCount() + size + rows;
+    ia.reserve(entries);
+    ja.reserve(entries);
+    ar.reserve(entries);
+
     for (std::size_t j = 0; j < size; ++j) {
-      for (std::size_t i = 0; i < size; ++i) {
-        ia.push_back(i + 1);
+      for (std::size_t k = coeffs.getColumnBegin(j); k < coeffs.getColumnEnd(j); ++k) {
+        ia.push_back(coeffs.getRow(k) + 1);
         ja.push_back(j + 1);
-        ar.push_back(coeffs(i, j));
+        ar.push_back(coeffs.getValue(k));
       }
     }
 
@@ -96,7 +743,9 @@ namespace disc {
       ia.push_back(nrows);
       ja.push_back(k + 1);
       ar.push_back(1.0);
+    }
 
+    for (std::size_t k = 0; k < rows; ++k) {
       ia.push_back(k + 1);
       ja.push_back(ncols);
       ar.push_back(-1.0);
@@ -112,28 +761,92 @@ namespace disc {
       glp_write_lp(prob, 0, filename);
     }
 
-    glp_smcp smcp;
-    glp_init_smcp(&smcp);
-    smcp.presolve = GLP_OFF;
-    smcp.tm_lim = 20*60*1000; // 20 min
-    smcp.msg_lev = GLP_MSG_ALL;
+    std::vector<double> pi(size);
+    bool solved = false;
+    bool defined = false;
 
-    int ret = glp_simplex(prob, &smcp);
+    if (options.method == LpMethod::InteriorPoint) {
+      glp_iptcp iptcp;
+      glp_init_iptcp(&iptcp);
+      iptcp.msg_lev = GLP_MSG_ALL;
 
-    std::vector<double> pi(size);
+      int ret = glp_interior(prob, &iptcp);
+      int status = glp_ipt_status(prob);
 
-    if (ret != 0 || glp_get_status(prob) != GLP_OPT) {
-      glp_delete_prob(prob);
+      solved = ret == 0 && status == GLP_OPT;
+      defined = status != GLP_UNDEF;
 
-      std::cerr << "Can not solve!\n";
+      for (std::size_t k = 0; defined && k < size; ++k) {
+        pi[k] = glp_ipt_col_prim(prob, k + 1);
+      }
+    } else {
+      glp_smcp smcp;
+      glp_init_smcp(&smcp);
+      smcp.msg_lev = GLP_MSG_ALL;
+
+      // the presolver does not use the basis, and does not give a solution
+      // when the problem is not solved
+      smcp.presolve = options.presolve && options.start.empty() ? GLP_ON : GLP_OFF;
+
+      if (options.timeLimit > 0) {
+        smcp.tm_lim = static_cast<int>(std::min(options.timeLimit * 1000, static_cast<double>(INT_MAX)));
+      }
+
+      if (!options.start.empty()) {
+        assert(options.start.size() == size);
+        setWarmBasis(prob, coeffs, options.start);
+      }
+
+      int ret = glp_simplex(prob, &smcp);
+
+      solved = ret == 0 && glp_get_status(prob) == GLP_OPT;
+      defined = glp_get_prim_stat(prob) != GLP_UNDEF;
+
+      for (std::size_t k = 0; defined && k < size; ++k) {
+        pi[k] = glp_get_col_prim(prob, k + 1);
+      }
+    }
+
+    glp_delete_prob(prob);
+
+    if (solved) {
       return pi;
     }
 
-    for (std::size_t k = 0; k < size; ++k) {
-      pi[k] = glp_get_col_prim(prob, k + 1);
+    // the best feasible point among the last point of the solver, the warm
+    // start and the uniform distribution
+
+    std::cerr << "Can not solve, keeping the best feasible solution\n";
+
+    std::vector<std::vector<double>> candidates;
+
+    if (defined) {
+      candidates.push_back(pi);
     }
 
-    glp_delete_prob(prob);
+    if (!options.start.empty()) {
+      candidates.push_back(options.start);
+    }
+
+    candidates.push_back(std::vector<double>(size, 1.0));
+
+    double best = -std::numeric_limits<double>::infinity();
+
+    for (auto& candidate : candidates) {
+      if (!makeFeasible(candidate)) {
+        continue;
+      }
+
+      auto probabilities = computeProbabilities(coeffs, candidate);
+      double pmin = probabilities.empty() ? 0.0 : *std::min_element(probabilities.begin(), probabilities.end());
+
+      if (pmin > best) {
+        best = pmin;
+        pi = candidate;
+      }
+    }
+
+    std::cerr << "p_min of the solution: " << best << '\n';
 
     return pi;
   }
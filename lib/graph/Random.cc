@@ -33,4 +33,12 @@ namespace disc {
     return std::mt19937(seeds);
   }
 
+  Engine getStreamEngine(uint64_t seed, uint64_t stream) {
+    std::seed_seq seeds({
+      static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+      static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)
+    });
+    return std::mt19937(seeds);
+  }
+
 }
@@ -0,0 +1,199 @@
+/*
+ * Graph exploration
+ * Copyright (C) 2017 Julien Bernard
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <disc/graph/Snapshot.h>
+
+#include <cstdio>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace disc {
+
+  namespace {
+
+    /*
+     * snapshot format
+     *
+     * header, signature, engine state (as written by operator<<), then for
+     * each part: header, offsets (one word per column plus one), rows (one
+     * 32 bits index per entry), values (one double per entry)
+     */
+
+    constexpr char SnapshotMagic[8] = { 'D', 'I', 'S', 'C', 'S', 'N', 'A', 'P' };
+    constexpr uint32_t SnapshotVersion = 2;
+
+    struct SnapshotHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t partCount;
+      uint64_t signatureSize;
+      uint64_t engineSize;
+      uint64_t seed;
+      uint64_t progress;
+    };
+
+    struct PartHeader {
+      uint64_t rows;
+      uint64_t cols;
+      uint64_t entries;
+    };
+
+    static_assert(sizeof(std::size_t) == sizeof(uint64_t), "Offsets are stored in place");
+
+    template<typename T>
+    bool readArray(std::istream& in, std::vector<T>& data, uint64_t size) {
+      data.resize(size);
+      in.read(reinterpret_cast<char *>(data.data()), size * sizeof(T));
+      return static_cast<bool>(in);
+    }
+
+  }
+
+  AlphaSnapshot::AlphaSnapshot(std::string filename, double interval)
+  : m_filename(std::move(filename))
+  , m_interval(interval)
+  , m_last(std::chrono::steady_clock::now())
+  {
+  }
+
+  bool AlphaSnapshot::load(const std::string& signature, AlphaState& state) const {
+    std::ifstream in(m_filename, std::ios::binary);
+
+    if (!in) {
+      return false;
+    }
+
+    SnapshotHeader header;
+
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof header) || !std::equal(std::begin(SnapshotMagic), std::end(SnapshotMagic), header.magic)) {
+      std::cerr << "Invalid snapshot '" << m_filename << "'\n";
+      return false;
+    }
+
+    if (header.version != SnapshotVersion) {
+      std::cerr << "Unsupported snapshot version: " << header.version << '\n';
+      return false;
+    }
+
+    std::string fileSignature(header.signatureSize, '\0');
+    std::string engine(header.engineSize, '\0');
+
+    if (!in.read(&fileSignature[0], header.signatureSize) || !in.read(&engine[0], header.engineSize)) {
+      std::cerr << "Invalid snapshot '" << m_filename << "'\n";
+      return false;
+    }
+
+    if (fileSignature != signature) {
+      std::cerr << "Snapshot '" << m_filename << "' is for another computation, it is ignored\n";
+      return false;
+    }
+
+    AlphaState res;
+    res.seed = header.seed;
+    res.progress = header.progress;
+
+    std::istringstream engineStream(engine);
+    engineStream >> res.engine;
+
+    for (uint32_t i = 0; i < header.partCount; ++i) {
+      PartHeader part;
+      std::vector<std::size_t> offsets;
+      std::vector<SparseMatrix<double>::RowIndex> rows;
+      std::vector<double> values;
+
+      if (!in.read(reinterpret_cast<char *>(&part), sizeof part) || !readArray(in, offsets, part.cols + 1) || !readArray(in, rows, part.entries) || !readArray(in, values, part.entries) || offsets.back() != part.entries) {
+        std::cerr << "Invalid snapshot '" << m_filename << "'\n";
+        return false;
+      }
+
+      res.parts.emplace_back(part.rows, std::move(offsets), std::move(rows), std::move(values));
+    }
+
+    if (!engineStream) {
+      std::cerr << "Invalid snapshot '" << m_filename << "'\n";
+      return false;
+    }
+
+    state = std::move(res);
+    return true;
+  }
+
+  bool AlphaSnapshot::isDue() const {
+    return std::chrono::steady_clock::now() - m_last >= m_interval;
+  }
+
+  bool AlphaSnapshot::save(const std::string& signature, const AlphaState& state) {
+    m_last = std::chrono::steady_clock::now();
+
+    std::ostringstream engineStream;
+    engineStream << state.engine;
+    std::string engine = engineStream.str();
+
+    std::string temporary = m_filename + ".tmp";
+
+    {
+      std::ofstream out(temporary, std::ios::binary);
+
+      if (!out) {
+        std::cerr << "Can not open '" << temporary << "'\n";
+        return false;
+      }
+
+      SnapshotHeader header;
+      std::copy(std::begin(SnapshotMagic), std::end(SnapshotMagic), header.magic);
+      header.version = SnapshotVersion;
+      header.partCount = static_cast<uint32_t>(state.parts.size());
+      header.signatureSize = signature.size();
+      header.engineSize = engine.size();
+      header.seed = state.seed;
+      header.progress = state.progress;
+
+      out.write(reinterpret_cast<const char *>(&header), sizeof header);
+      out.write(signature.data(), signature.size());
+      out.write(engine.data(), engine.size());
+
+      for (auto& matrix : state.parts) {
+        PartHeader part;
+        part.rows = matrix.getRows();
+        part.cols = matrix.getCols();
+        part.entries = matrix.getNonZeroCount();
+
+        out.write(reinterpret_cast<const char *>(&part), sizeof part);
+        out.write(reinterpret_cast<const char *>(matrix.getOffsetData()), (part.cols + 1) * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char *>(matrix.getRowData()), part.entries * sizeof(SparseMatrix<double>::RowIndex));
+        out.write(reinterpret_cast<const char *>(matrix.getValueData()), part.entries * sizeof(double));
+      }
+
+      if (!out.flush()) {
+        std::cerr << "Can not write '" << temporary << "'\n";
+        return false;
+      }
+    }
+
+    if (std::rename(temporary.c_str(), m_filename.c_str()) != 0) {
+      std::cerr << "Can not write '" << m_filename << "'\n";
+      return false;
+    }
+
+    return true;
+  }
+
+}
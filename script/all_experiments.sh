@@ -1,6 +1,7 @@
 #!/bin/dash
 
 ONLY_PRINT=0
+BINARY=0
 
 for ARG in "$@"
 do
@@ -9,6 +10,10 @@ do
 			ONLY_PRINT=1
 			shift
 			;;
+		--binary)
+			BINARY=1
+			shift
+			;;
 	esac
 done
 
@@ -20,6 +25,7 @@ then
 	echo "" 1>&2
 	echo "Option:" 1>&2
 	echo "\t--only-print just print commands to standard output" 1>&2
+	echo "\t--binary convert the graphs to the binary format before running" 1>&2
 	exit 1
 fi
 
@@ -29,6 +35,26 @@ GRAPH_DIR=$2
 EXPERIMENT_LIST=$(find $EXEC_DIR -type f -executable -name "xp_*")
 GRAPH_LIST=$(find $GRAPH_DIR -name *.graph)
 
+if [ $BINARY -eq 1 ]
+then
+	mkdir -p bgraph
+	BINARY_LIST=""
+
+	for GRAPH in $GRAPH_LIST
+	do
+		BINARY_GRAPH="bgraph/$(basename ${GRAPH%.*}).bgraph"
+
+		if [ ! -f $BINARY_GRAPH ]
+		then
+			$EXEC_DIR/graph_convert $GRAPH $BINARY_GRAPH > /dev/null 2>&1
+		fi
+
+		BINARY_LIST="$BINARY_LIST $BINARY_GRAPH"
+	done
+
+	GRAPH_LIST=$BINARY_LIST
+fi
+
 FACTOR_LIST="10 1000"
 THRESHOLD_LIST="10 50"
 
@@ -45,13 +71,20 @@ run_experiment() {
 	OTHER_ARGS="$(echo "$@" | tr -s ' ' '-')-"
 
 	LOG_FILE="log/$(basename $EXPERIMENT)-$OTHER_ARGS$(basename ${GRAPH%.*}).log"
-	timeout 12h $EXPERIMENT $GRAPH "$@" > $LOG_FILE 2>&1
-	if [ $? -eq 124 ]
+	SNAPSHOT_FILE="snapshot/$(basename $EXPERIMENT)-$OTHER_ARGS$(basename ${GRAPH%.*}).snap"
+	timeout 12h $EXPERIMENT --snapshot $SNAPSHOT_FILE $GRAPH "$@" > $LOG_FILE 2>&1
+	STATUS=$?
+	if [ $STATUS -eq 0 ]
+	then
+		echo "\t$GREEN$EXPERIMENT $GRAPH "$@" done$NC"
+		rm -f $SNAPSHOT_FILE
+	elif [ $STATUS -eq 124 ]
 	then
-		echo "\t$RED$EXPERIMENT $GRAPH "$@" timeout$NC"
+		echo "\t$RED$EXPERIMENT $GRAPH "$@" timeout (resumed from $SNAPSHOT_FILE on the next run)$NC"
 		rm $LOG_FILE
 	else
-		echo "\t$GREEN$EXPERIMENT $GRAPH "$@" done$NC"
+		# a crash or a kill (137 when out of memory) keeps the snapshot
+		echo "\t$RED$EXPERIMENT $GRAPH "$@" failed with status $STATUS, see $LOG_FILE (resumed from $SNAPSHOT_FILE on the next run)$NC"
 	fi
 }
 
@@ -64,10 +97,11 @@ print_experiment() {
 	OTHER_ARGS="$(echo "$@" | tr -s ' ' '-')-"
 
 	LOG_FILE="log/$(basename $EXPERIMENT)-$OTHER_ARGS$(basename ${GRAPH%.*}).log"
-	echo "timeout 12h $EXPERIMENT $GRAPH "$@" > $LOG_FILE 2>&1"
+	SNAPSHOT_FILE="snapshot/$(basename $EXPERIMENT)-$OTHER_ARGS$(basename ${GRAPH%.*}).snap"
+	echo "timeout 12h $EXPERIMENT --snapshot $SNAPSHOT_FILE $GRAPH "$@" > $LOG_FILE 2>&1"
 }
 
-mkdir -p log
+mkdir -p log snapshot
 
 for GRAPH in $GRAPH_LIST
 do